@@ -0,0 +1,80 @@
+#ifndef ivutils_AdaptiveRamp_h
+#define ivutils_AdaptiveRamp_h
+
+#include "ivutils/ParametersList.h"
+#include "ivutils/Schema.h"
+
+#include <vector>
+#include <cstddef>
+
+namespace ivutils
+{
+  /// Generator of voltage stages, refined where the current varies quickly
+  /// \note The voltage is only ramped in one direction: the step is reduced
+  ///  as soon as the current rises (or bends) faster than a threshold, and
+  ///  enlarged again when the curve flattens
+  class AdaptiveRamp
+  {
+    public:
+      /// Validated ramp parameters
+      struct Settings
+      {
+        double start, stop;
+        int max_points;
+        double max_step, min_step;
+        double rise_threshold, curvature_threshold;
+        double compliance;
+        /// Description of all ramp parameters
+        static const Schema<Settings>& schema();
+      };
+
+      /// Build a ramp from its list of parameters
+      /// \param[in] params Range ("start", "stop"), points budget ("maxPoints"),
+      ///  steps ("maxStep", "minStep"), refinement thresholds ("riseThreshold",
+      ///  "curvatureThreshold"), and current limit ("compliance")
+      /// \param[in] anchors Voltages which are never stepped over
+      AdaptiveRamp( const ParametersList& params, const std::vector<double>& anchors = std::vector<double>() );
+      /// Build a ramp from its validated parameters
+      /// \throw std::runtime_error if the points budget cannot cover the range with the largest step
+      AdaptiveRamp( const Settings& settings, const std::vector<double>& anchors = std::vector<double>() );
+
+      /// Restart the ramp from its first stage
+      void reset();
+      /// Compute the next voltage stage
+      /// \return False if the ramp is finished
+      bool next( double& voltage );
+      /// Add the current measured at the last voltage stage
+      void add( double voltage, double current );
+      /// Current limit at which the ramp is stopped (0 if disabled)
+      double compliance() const { return compliance_; }
+      /// Set the current limit at which the ramp is stopped (0 to disable)
+      void setCompliance( double compliance ) { compliance_ = compliance; }
+
+      /// Maximal number of voltage stages
+      size_t maxPoints() const { return max_points_; }
+      /// Largest allowed voltage step
+      double maxStep() const { return max_step_; }
+      /// All voltage stages measured
+      const std::vector<double>& voltages() const { return voltages_; }
+
+    private:
+      /// Currents below this value are considered as null for the relative variations
+      static const double CURRENT_FLOOR;
+      /// Minimal number of stages to reach the end of the range, stopping at all anchors
+      size_t pointsNeeded( double from ) const;
+
+      double start_, stop_;
+      size_t max_points_;
+      double max_step_, min_step_;
+      double rise_threshold_; ///< maximal relative current increase per maximal step
+      double curvature_threshold_; ///< maximal change of the logarithmic slope (per maximal step)
+      double compliance_; ///< current at which the ramp is stopped (0 if disabled)
+      std::vector<double> anchors_;
+
+      double step_; ///< current voltage step (absolute value)
+      bool finished_;
+      std::vector<double> voltages_, log_currents_;
+  };
+}
+
+#endif
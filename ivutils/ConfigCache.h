@@ -0,0 +1,52 @@
+#ifndef ivutils_ConfigCache_h
+#define ivutils_ConfigCache_h
+
+#include "ivutils/ParametersList.h"
+
+#include <string>
+#include <vector>
+
+namespace ivutils
+{
+  /// Binary cache of a parsed configuration card
+  /// \note The cache holds the content hash of all files the card was built
+  ///  from (the card itself, and all modules it imports); it is only used
+  ///  as long as none of them changed
+  class ConfigCache
+  {
+    public:
+      /// Build the cache handler for a configuration card
+      /// \param[in] card Path to the configuration card
+      explicit ConfigCache( const std::string& card );
+
+      /// Path to the cache file
+      const std::string& path() const { return path_; }
+      /// Load the cached configuration, if still valid
+      /// \param[out] params Parsed configuration
+      /// \return False if the cache is missing, stale, or corrupted
+      bool load( ParametersList& params ) const;
+      /// Store a parsed configuration
+      /// \param[in] params Parsed configuration
+      /// \param[in] dependencies Paths to all files the configuration was built from
+      void save( const ParametersList& params, const std::vector<std::string>& dependencies ) const;
+
+      /// Append the binary representation of a parameters list
+      static void serialise( const ParametersList& params, std::string& out );
+      /// Decode a parameters list from its binary representation
+      /// \param[in,out] data Binary representation, advanced past the decoded list
+      /// \throw std::runtime_error if the representation is invalid
+      static ParametersList deserialise( StringView& data );
+
+    private:
+      static const char MAGIC[4];
+      static const uint32_t VERSION;
+      /// Content hash of a file
+      /// \param[out] hash File content hash
+      /// \return False if the file cannot be read
+      static bool fileHash( const std::string& path, uint64_t& hash );
+
+      std::string path_;
+  };
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef ivutils_CsvOutput_h
+#define ivutils_CsvOutput_h
+
+#include "ivutils/OutputSink.h"
+
+#include <fstream>
+#include <mutex>
+#include <chrono>
+#include <string>
+
+namespace ivutils
+{
+  /// Append-only output of all readings into plain text (CSV) files
+  /// \note Raw readings and stages summaries are written into
+  ///  "<prefix>_readings.csv" and "<prefix>_stages.csv" respectively;
+  ///  files are flushed after each stage, and at a bounded interval
+  class CsvOutput : public OutputSink
+  {
+    public:
+      /// Open the output files
+      /// \param[in] prefix Output files path prefix
+      /// \param[in] flush_interval Maximal time between two flushes of the files on disk
+      explicit CsvOutput( const std::string& prefix, const std::chrono::seconds& flush_interval = DEFAULT_FLUSH_INTERVAL );
+
+      void addReading( unsigned short station, unsigned short stage, double voltage, const Reading& reading ) override;
+      void addStage( unsigned short station, unsigned short stage, double voltage, double mean, double stdev, unsigned int num_readings ) override;
+      void addStabilityPoint( unsigned short station, double time, double current ) override;
+
+    private:
+      static const std::chrono::seconds DEFAULT_FLUSH_INTERVAL;
+      /// Seconds elapsed since the files opening
+      double elapsed() const;
+      /// Flush the files if the last flush is too old (lock to be held)
+      void autoFlush( bool force = false );
+
+      std::mutex mutex_;
+      std::ofstream readings_;
+      std::ofstream stages_;
+      std::ofstream stability_;
+      std::chrono::steady_clock::duration flush_interval_;
+      std::chrono::steady_clock::time_point last_flush_;
+      const std::chrono::system_clock::time_point start_;
+  };
+}
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef ivutils_DataBlock_h
+#define ivutils_DataBlock_h
+
+#include "ivutils/StringView.h"
+
+namespace ivutils
+{
+  /// Check if the host stores numbers in big-endian byte order
+  bool hostIsBigEndian();
+  /// Decode an IEEE-488.2 arbitrary block of floating point values
+  /// \note Both the definite-length (#<n><length><data>) and the
+  ///  indefinite-length (#0<data>, terminated by a newline) forms are handled
+  /// \param[in] block Raw block, starting with its '#' header
+  /// \param[in] value_size Size of each value, in bytes (4 for REAL,32, 8 for REAL,64)
+  /// \param[in] big_endian Byte order of the values in the block
+  /// \param[out] values Caller-supplied array of values to be filled
+  /// \param[in] max_values Capacity of the array
+  /// \return Number of values decoded
+  size_t decodeBlock( const StringView& block, size_t value_size, bool big_endian, double* values, size_t max_values );
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define ivutils_Device_h
 
 #include "ivutils/Messenger.h"
+#include "ivutils/Reading.h"
 
 #include <vector>
 #include <string>
@@ -10,26 +11,123 @@
 namespace ivutils
 {
   class ParametersList;
+  template<typename S> class Schema;
   /// Basic communication protocol handler
   class Device : public Messenger
   {
     public:
       static const std::string M_DEVICE_ID, M_RESET, M_READ;
+      /// Numerical data transfer format
+      enum DataFormat { ascii, real32, real64 };
+      /// Validated device parameters
+      struct Settings
+      {
+        int address, secondary_address, board;
+        std::vector<std::string> config_commands, operation_commands, closing_commands;
+        int input_buffer_size;
+        std::string completion_mode;
+        int query_timeout, buffer_timeout;
+        std::string data_format;
+        std::vector<std::string> data_elements;
+        bool warm_attach;
+        std::string state_file, state_query;
+        /// Description of all device parameters
+        static const Schema<Settings>& schema();
+      };
 
-      Device() {}
+      Device() : data_format_( ascii ), big_endian_( false ), buffer_timeout_ms_( 0 ), warm_attached_( false ) {}
       ~Device();
       /// Build a messenger at a list of parameters
       explicit Device( const ParametersList& params );
+      /// Build a messenger from its validated parameters
+      explicit Device( const Settings& settings );
       void reset() const;
+      /// Apply the configuration and operation commands
+      /// \note Configuration commands are skipped if the module was warm-attached
       void initialise() const;
+      /// Module identification string, retrieved once and cached
+      const std::string& identity() const;
+      /// Check if the module was attached without being reset and reconfigured
+      bool warmAttached() const { return warm_attached_; }
+      /// Select the numerical data transfer format
+      /// \note Binary values are transferred in the host byte order
+      void setDataFormat( const DataFormat& format );
+      /// Parse a data format name ("ascii", "real32", or "real64")
+      static DataFormat dataFormat( const std::string& name );
 
-      std::pair<unsigned long,double> readValue( const std::string command = M_READ, std::string unit = "" ) const;
+      /// Change a module setting, unless it is known to already hold this value
+      /// \param[in] header SCPI header of the setting (e.g. ":SOUR:VOLT:LEV")
+      /// \param[in] value Requested value
+      /// \return True if a command was transmitted
+      bool set( const std::string& header, const std::string& value ) const;
+      /// Change a numerical module setting, unless it is known to already hold this value
+      bool set( const std::string& header, double value ) const;
+      /// Change a numerical module setting, without waiting for its transmission
+      std::future<bool> setAsync( const std::string& header, double value ) const;
+      /// Retrieve a module setting, from the shadow model if it is known
+      /// \param[in] header SCPI header of the setting (e.g. ":SOUR:VOLT:LEV")
+      std::string setting( const std::string& header ) const;
+      /// Re-read a module setting from the instrument, and update the shadow model
+      /// \param[in] header SCPI header of the setting (e.g. ":SOUR:VOLT:LEV")
+      std::string verify( const std::string& header ) const;
+
+      /// Interrogate the module and decode all numerical values of its answer
+      /// \param[in] command Query to be transmitted
+      /// \param[out] values Caller-supplied array of values to be filled
+      /// \param[in] max_values Capacity of the array
+      /// \param[in] timeout_ms Deadline (in ms) for the answer to be available (0 for the default one)
+      /// \return Number of values decoded
+      size_t readValues( const std::string& command, double* values, size_t max_values, unsigned int timeout_ms = 0 ) const;
+      /// Interrogate the module and parse all readings of its answer
+      /// \param[in] command Query to be transmitted
+      /// \param[out] readings List of readings to be filled
+      /// \param[in] timeout_ms Deadline (in ms) for the answer to be available (0 for the default one)
+      /// \return Number of readings parsed
+      size_t readReadings( const std::string& command, std::vector<Reading>& readings, unsigned int timeout_ms = 0 ) const;
+      /// Interrogate the module for a single reading
+      Reading readValue( const std::string command = M_READ, std::string unit = "" ) const;
+      /// Interrogate the module for a single reading, without waiting for its answer
+      std::future<Reading> readValueAsync( const std::string& command = M_READ ) const;
+      /// Acquire a series of readings in the instrument buffer, and retrieve them in a single transfer
+      /// \param[in] num_readings Number of readings to be triggered
+      /// \return List of readings, sampled at the instrument's own cadence
+      std::vector<Reading> readBuffer( size_t num_readings ) const;
+      /// Acquire and retrieve a series of readings, without waiting for their transfer
+      std::future<std::vector<Reading> > readBufferAsync( size_t num_readings ) const;
+      /// Acquire a series of readings in the instrument buffer, and wait for the acquisition to complete
+      /// \param[in] num_readings Number of readings to be triggered
+      void acquireBuffer( size_t num_readings ) const;
+      /// Retrieve all readings of a completed buffered acquisition
+      std::vector<Reading> fetchBuffer( size_t num_readings ) const;
+      /// Retrieve all readings of a completed buffered acquisition, without waiting for their transfer
+      std::future<std::vector<Reading> > fetchBufferAsync( size_t num_readings ) const;
 
     private:
       static const std::regex RGX_STR_ANSW, RGX_NUM_ANSW;
+      static const unsigned int DEFAULT_BUFFER_TIMEOUT_MS;
+      /// Try to reuse the module state left by a previous session
+      /// \return True if the module configuration is unchanged since then
+      bool attach() const;
+      /// Fingerprint of the module configuration and state
+      std::string fingerprint() const;
+      /// Stop a failed buffered acquisition, and restore the single-reading trigger model
+      void abortBuffer() const;
+      /// Check if a (normalised) setting may alter the trigger, trace, or data format
+      ///  model, in which case it is never to overtake a pending acquisition
+      static bool triggerSetting( const std::string& header );
       std::vector<std::string> configCommands_;
       std::vector<std::string> operationCommands_;
       std::vector<std::string> closingCommands_;
+      DataFormat data_format_;
+      bool big_endian_; ///< byte order for binary transfers
+      ReadingParser reading_parser_;
+      mutable std::vector<double> values_; ///< decoding buffer for binary transfers
+      mutable std::vector<Reading> readings_; ///< parsing buffer for single readings
+      unsigned int buffer_timeout_ms_; ///< deadline for a buffered acquisition to complete (in ms)
+      std::string state_file_; ///< file holding the module fingerprint for a warm attach (empty if disabled)
+      std::string state_query_; ///< cheap query reading back a configured setting, altered by a reset or a power cycle
+      bool warm_attached_;
+      mutable std::string identity_;
   };
 }
 
@@ -0,0 +1,58 @@
+#ifndef ivutils_GuiOutput_h
+#define ivutils_GuiOutput_h
+
+#include "ivutils/OutputSink.h"
+#include "ivutils/LivePlot.h"
+
+#include <string>
+#include <vector>
+
+class TVirtualPad;
+class TH1;
+
+namespace ivutils
+{
+  /// Live rendering of all quantities measured by the stations
+  /// \note Quantities are published from the stations threads, and only
+  ///  rendered at each refresh by the graphical interface thread
+  class GuiOutput : public OutputSink
+  {
+    public:
+      /// Build the plots for a list of stations
+      /// \param[in] stations Names of all stations (empty for a single-station setup)
+      explicit GuiOutput( const std::vector<std::string>& stations );
+
+      void addReading( unsigned short station, unsigned short stage, double voltage, const Reading& reading ) override;
+      void addStage( unsigned short station, unsigned short stage, double voltage, double mean, double stdev, unsigned int num_readings ) override;
+      void addStabilityPoint( unsigned short station, double time, double current ) override;
+
+      //--- graphical interface side (ROOT lock to be held)
+
+      /// Draw the scan plots of a station
+      /// \param[in] pad_meas Pad where to draw the I-V curve
+      /// \param[in] pad_stab Pad where to draw the stability test curve
+      void draw( unsigned short station, TVirtualPad* pad_meas, TVirtualPad* pad_stab );
+      /// Draw the raw readings of a station versus their timestamp, as in a test acquisition
+      /// \param[in] pad Pad where to draw the readings
+      /// \param[in] hist Histogram to be filled with all currents (in pA)
+      /// \param[in] hist_pad Pad where to draw the histogram
+      void drawTest( unsigned short station, TVirtualPad* pad, TH1* hist, TVirtualPad* hist_pad );
+      /// Detach all plots from their pads
+      void detach();
+      /// Render all points measured since the last refresh
+      void refresh();
+
+    private:
+      /// All plots of a station
+      struct StationPlots
+      {
+        LivePlot meas;
+        LivePlot stability;
+        LivePlot test;
+      };
+      std::vector<StationPlots> plots_;
+      bool test_mode_; ///< raw readings are to be rendered
+  };
+}
+
+#endif
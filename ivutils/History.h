@@ -0,0 +1,72 @@
+#ifndef ivutils_History_h
+#define ivutils_History_h
+
+#include <vector>
+#include <cstddef>
+
+namespace ivutils
+{
+  /// Fixed-size multi-resolution history of a time series
+  /// \note The most recent points are kept at full resolution in a ring buffer;
+  ///  older points are summarised into buckets (extrema and mean), whose width
+  ///  doubles each time all buckets are used; memory is constant however
+  ///  long the series is
+  class History
+  {
+    public:
+      /// Single point of the series
+      struct Point
+      {
+        double x, y;
+      };
+      /// Summary of a range of consecutive points
+      struct Bucket
+      {
+        double x_first, x_last; ///< abscissa range
+        size_t count; ///< number of points summarised
+        double sum; ///< sum of all ordinates
+        Point low, high; ///< points with the lowest and highest ordinates
+        /// Mean ordinate
+        double mean() const { return count > 0 ? sum/count : 0.; }
+      };
+
+      /// Build an empty history
+      /// \param[in] raw_capacity Number of most recent points kept at full resolution
+      /// \param[in] num_buckets Number of buckets summarising all older points
+      explicit History( size_t raw_capacity = DEFAULT_RAW_CAPACITY, size_t num_buckets = DEFAULT_NUM_BUCKETS );
+
+      /// Forget all points
+      void clear();
+      /// Add a point after all previous ones
+      void add( double x, double y );
+      /// Total number of points added
+      size_t count() const { return count_; }
+      /// Summaries of all points older than the full-resolution ones
+      const std::vector<Bucket>& buckets() const { return buckets_; }
+      /// Multi-resolution view of the series
+      /// \param[out] points Extrema of all buckets, followed by all full-resolution points
+      void points( std::vector<Point>& points ) const;
+
+      /// Decimate a series while preserving its visual shape
+      /// \note Largest-triangle-three-buckets algorithm (Steinarsson, 2013)
+      /// \param[in] in Series to be decimated, ordered in abscissa
+      /// \param[in] threshold Maximal number of points kept
+      /// \param[out] out Decimated series
+      static void decimate( const std::vector<Point>& in, size_t threshold, std::vector<Point>& out );
+
+    private:
+      static const size_t DEFAULT_RAW_CAPACITY, DEFAULT_NUM_BUCKETS;
+      /// Summarise a point evicted from the ring buffer
+      void aggregate( const Point& point );
+
+      size_t raw_capacity_;
+      size_t num_buckets_;
+      std::vector<Point> raw_; ///< ring buffer of the most recent points
+      size_t raw_begin_; ///< index of the oldest point in the ring buffer
+      std::vector<Bucket> buckets_;
+      size_t bucket_width_; ///< number of points summarised in a complete bucket
+      size_t count_;
+  };
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef ivutils_IOExecutor_h
+#define ivutils_IOExecutor_h
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+namespace ivutils
+{
+  /// Single-threaded executor for all input/output operations on a device
+  /// \note Tasks are run by decreasing priority, then in their submission order;
+  ///  ordered tasks (e.g. depending on the trigger state of the device) never
+  ///  overtake each other, whatever their priority
+  class IOExecutor
+  {
+    public:
+      typedef std::chrono::steady_clock Clock;
+      /// Priority class of a task, from the most to the least urgent
+      enum Priority {
+        safety, ///< status and compliance polls
+        setPoint, ///< configuration and set-point changes
+        bulk ///< large data transfers
+      };
+
+      /// Build an executor; its I/O thread is only started with the first task
+      IOExecutor();
+      /// Run all pending tasks, and stop the I/O thread
+      ~IOExecutor();
+
+      /// Check if the caller is running on the I/O thread
+      bool inWorkerThread() const { return std::this_thread::get_id() == worker_id_.load(); }
+      /// Check if the I/O thread was started
+      bool started() const { return worker_id_.load() != std::thread::id(); }
+      /// Queue a task to be run on the I/O thread
+      /// \param[in] priority Priority class of the task
+      /// \param[in] deadline Latest time for the task to be started; if
+      ///  expired, the task is dropped and its future holds an exception
+      /// \param[in] ordered Task is to be run after all ordered tasks submitted before
+      /// \return Future result of the task
+      template<typename F> std::future<typename std::result_of<F()>::type> submit( F&& task, const Priority& priority = setPoint, const Clock::time_point& deadline = Clock::time_point::max(), bool ordered = true ) {
+        typedef typename std::result_of<F()>::type result_type;
+        auto packaged = std::make_shared<std::packaged_task<result_type()> >(
+          [task = std::forward<F>( task ), deadline]() mutable -> result_type {
+            if ( Clock::now() > deadline )
+              throw std::runtime_error( "I/O operation deadline expired before its execution!" );
+            return task();
+          } );
+        std::future<result_type> result = packaged->get_future();
+        {
+          std::lock_guard<std::mutex> lock( mutex_ );
+          if ( !thread_.joinable() ) {
+            thread_ = std::thread( &IOExecutor::run, this );
+            worker_id_ = thread_.get_id();
+          }
+          if ( ordered )
+            promote( priority );
+          tasks_.emplace_back( Task{ priority, next_sequence_++, ordered, [packaged]() { ( *packaged )(); } } );
+          std::push_heap( tasks_.begin(), tasks_.end() );
+        }
+        cond_.notify_one();
+        return result;
+      }
+
+    private:
+      /// Queued task, along with its scheduling attributes
+      struct Task
+      {
+        Priority priority;
+        unsigned long long sequence; ///< submission order
+        bool ordered; ///< never overtakes an earlier ordered task
+        std::function<void()> run;
+        /// Ordering in the heap (the top element is run first)
+        bool operator<( const Task& oth ) const {
+          if ( priority != oth.priority )
+            return priority > oth.priority;
+          return sequence > oth.sequence;
+        }
+      };
+      /// Raise all pending ordered tasks to a given priority, so that they run
+      ///  before an ordered task of this priority submitted afterwards (lock to be held)
+      void promote( const Priority& priority );
+      /// Main loop of the I/O thread
+      void run();
+
+      std::vector<Task> tasks_; ///< heap of pending tasks
+      unsigned long long next_sequence_;
+      std::mutex mutex_;
+      std::condition_variable cond_;
+      bool stop_;
+      std::thread thread_;
+      std::atomic<std::thread::id> worker_id_; ///< identifier of the I/O thread (default if not started)
+  };
+}
+
+#endif
@@ -1,15 +1,17 @@
 #ifndef ivutils_IVScanner_h
 #define ivutils_IVScanner_h
 
-#include "ivutils/PythonParser.h"
-#include "ivutils/Device.h"
+#include "ivutils/ScanRunner.h"
 
 #include "TApplication.h"
-#include "TGraphErrors.h"
-#include <fstream>
+
+#include <chrono>
+#include <mutex>
 
 namespace ivutils
 {
+  class GuiOutput;
+  /// Graphical front-end of the stations steering, with live plots and ROOT outputs
   class IVScanner : public TApplication
   {
     public:
@@ -21,25 +23,15 @@ namespace ivutils
       void scan() const;
 
     private:
-      void stabilityTest( std::vector<double>& i_ramp, std::vector<double>& i_stable ) const;
-
-      PythonParser parser_;
-      /// SourceMeter communication module
-      Device srcmeter_;
-      /// Ammeter communication module
-      Device ammeter_;
-
-      bool ramp_down_;
-      std::vector<double> ramping_stages_;
-      double v_test_; ///< Voltage to test stability (abs value)
-      size_t num_repetitions_; ///< current values per voltage
-      unsigned int stable_time_; ///< time for stabilizing after changing voltage (in seconds)
-      unsigned int time_at_test_; ///< timein stability test at voltage V_test (in seconds)
-      double voltage_at_test_;
-
-      mutable TGraphErrors gr_stability_vs_time_;
+      /// Interval between two refreshes of the graphical interface while stations are running
+      static const std::chrono::milliseconds GUI_REFRESH_TIME;
+
+      ScanRunner runner_;
+      /// Live plots of the current operation (if any), refreshed while stations are running
+      mutable GuiOutput* gui_output_;
+      /// Lock guarding the pads and plots of the graphical interface (never taken by the file output)
+      mutable std::mutex gui_mutex_;
   };
 }
 
 #endif
-
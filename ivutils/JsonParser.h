@@ -0,0 +1,31 @@
+#ifndef ivutils_JsonParser_h
+#define ivutils_JsonParser_h
+
+#include "ivutils/ParametersList.h"
+
+namespace ivutils
+{
+  /// Parse a JSON configuration file, without any external dependency
+  /// \note The top-level object holds the configuration (as the "config"
+  ///  dictionary of a Python card). Values are mapped as in Python cards:
+  ///  integers and booleans to int, other numbers to double, objects to
+  ///  parameters lists, and homogeneous arrays to vectors (integers are
+  ///  promoted to double in arrays holding both); null values and empty
+  ///  arrays are ignored. As an extension, "#" comments and trailing
+  ///  commas are accepted.
+  class JsonParser : public ParametersList
+  {
+    public:
+      JsonParser() = default;
+      /// Constructor from an external configuration file
+      explicit JsonParser( const char* config_file );
+
+      /// Parse a configuration from its JSON representation
+      /// \note The content is tokenised in a single pass, without copying
+      ///  (only strings holding escape sequences are decoded)
+      /// \throw std::runtime_error if the content is invalid, with its position
+      static ParametersList parse( const StringView& content );
+  };
+}
+
+#endif
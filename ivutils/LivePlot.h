@@ -0,0 +1,79 @@
+#ifndef ivutils_LivePlot_h
+#define ivutils_LivePlot_h
+
+#include "ivutils/History.h"
+
+#include "TGraphErrors.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class TVirtualPad;
+class TH1;
+
+namespace ivutils
+{
+  /// Graph filled by an acquisition thread, and rendered by the graphical interface thread
+  /// \note Points are published into a pending buffer, swapped and applied to
+  ///  the graph at each refresh; the acquisition never waits for a redraw
+  class LivePlot
+  {
+    public:
+      LivePlot();
+
+      /// Keep a bounded-memory history of all appended points, instead of the full series
+      /// \note The graph then shows a decimated view of this history, rebuilt at each
+      ///  refresh at a constant cost; indexed points and histograms are not supported
+      /// \param[in] history Multi-resolution history to be filled
+      /// \param[in] display_points Maximal number of points drawn
+      void setHistory( const History& history, size_t display_points = DEFAULT_DISPLAY_POINTS );
+
+      //--- acquisition side
+
+      /// Publish a point at a given index
+      void setPoint( size_t i, double x, double y, double ey = 0. );
+      /// Publish a point after all previous ones
+      void addPoint( double x, double y, double ey = 0. );
+      /// Remove all points
+      void clear();
+
+      //--- graphical interface side (ROOT lock to be held)
+
+      /// Draw the graph in a pad
+      void draw( TVirtualPad* pad, const char* option = "alp" );
+      /// Also fill the ordinates of all points into a histogram
+      void setHistogram( TH1* hist, TVirtualPad* pad );
+      /// Stop drawing into the pads (e.g. before their deletion), and drop the histogram
+      void detach() { pad_ = hist_pad_ = nullptr; hist_ = nullptr; }
+      /// Apply all points published since the last refresh, and redraw
+      /// \return True if the plot was modified
+      bool refresh();
+      /// Rendered graph
+      TGraphErrors& graph() { return graph_; }
+
+    private:
+      static const size_t DEFAULT_DISPLAY_POINTS;
+      /// Published point
+      struct Point
+      {
+        long index; ///< index in the graph (negative to append)
+        double x, y, ey;
+      };
+
+      std::mutex mutex_; ///< protects the pending buffer and clearing flag
+      std::vector<Point> pending_; ///< points published since the last refresh
+      std::vector<Point> rendering_; ///< points being applied (swapped with the pending buffer)
+      bool clear_pending_;
+      std::unique_ptr<History> history_; ///< bounded-memory history of all points (if set)
+      size_t display_points_;
+      bool history_modified_;
+      std::vector<History::Point> history_points_, display_; ///< history views, reused at each refresh
+      TGraphErrors graph_;
+      TVirtualPad* pad_;
+      TH1* hist_;
+      TVirtualPad* hist_pad_;
+  };
+}
+
+#endif
@@ -1,48 +1,179 @@
 #ifndef ivutils_Logger_h
 #define ivutils_Logger_h
 
+#include "ivutils/Config.h"
+
 #include <iostream>
+#include <fstream>
 #include <sstream>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+/// Emit a message, e.g. IVUTILS_LOG( info ) << ...; or IVUTILS_LOG( info, limiter ) << ...;
+/// \note The message content is not evaluated if its severity level is
+///  disabled, and the statement is stripped at compile time if this level is
+///  more verbose than the one compiled in
+#define IVUTILS_LOG( ... ) \
+  !ivutils::Logger::enabled( __VA_ARGS__ ) ? (void)0 : ivutils::LogVoidify() & ivutils::LogMessage( __VA_ARGS__ )
 
 namespace ivutils
 {
-  enum LogMessageType { error, warning, info };
-  class LogMessage
+  enum LogMessageType { error, warning, info, debug };
+  class LogRateLimiter;
+  /// Most verbose severity level compiled into the library
+  constexpr LogMessageType COMPILED_LOG_LEVEL = IVUTILS_LOG_LEVEL;
+  /// Asynchronous logging backend
+  /// \note Messages are pushed into a lock-free ring buffer, and
+  ///  timestamped, formatted and written by a background thread
+  class Logger
+  {
+    public:
+      /// Retrieve the (unique) logging backend
+      static Logger& get();
+      ~Logger();
+
+      /// Parse a severity level name ("error", "warning", "info", or "debug")
+      static LogMessageType level( const std::string& name );
+      /// Set the most verbose severity level to be emitted
+      static void setLevel( const LogMessageType& level ) { level_.store( level, std::memory_order_relaxed ); }
+      /// Check if messages of a given severity level are to be emitted
+      static bool enabled( const LogMessageType& type ) {
+        return type == error
+          || ( type <= COMPILED_LOG_LEVEL && type <= level_.load( std::memory_order_relaxed ) );
+      }
+      /// Check if rate-limited messages of a given severity level are to be emitted
+      static bool enabled( const LogMessageType& type, const LogRateLimiter& ) { return enabled( type ); }
+
+      /// Also write all messages into an output file
+      void setOutputFile( const std::string& filename );
+      /// Queue a message to be written
+      /// \note Informational and debugging messages are dropped if the ring is full, errors and warnings wait for a free slot
+      void push( const LogMessageType& type, std::string&& message );
+      /// Wait until all queued messages are written
+      /// \note Pending messages are written by the calling thread itself
+      void flush();
+
+    private:
+      Logger();
+      /// Log record, as stored in the ring
+      struct Record
+      {
+        std::atomic<size_t> sequence; ///< ring slot sequence number
+        LogMessageType type;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+      };
+      /// Number of slots in the ring (a power of 2)
+      static const size_t RING_SIZE;
+
+      /// Try to store a message into the ring
+      bool tryPush( const LogMessageType& type, std::string& message );
+      /// Check if a message is ready to be written
+      bool available() const;
+      /// Wake the writing thread up if it is waiting for messages
+      void wake();
+      /// Write all available messages in a single batch
+      /// \note May be called concurrently from any thread
+      /// \return Number of messages written
+      size_t writeBatch();
+      /// Main loop of the writing thread
+      void run();
+
+      /// Most verbose severity level to be emitted
+      static std::atomic<int> level_;
+
+      std::unique_ptr<Record[]> ring_;
+      std::atomic<size_t> enqueue_pos_; ///< next slot to be claimed by a producer
+      std::atomic<size_t> dequeue_pos_; ///< next slot to be written
+      std::atomic<size_t> num_dropped_; ///< messages dropped since the last batch
+      std::atomic<bool> running_;
+      std::atomic<bool> sleeping_; ///< writing thread is (about to be) waiting for messages
+      std::mutex wake_mutex_;
+      std::condition_variable wake_cond_;
+      std::mutex write_mutex_; ///< serialises the batches writing, and guards all members below
+      std::string batch_; ///< formatting buffer for a batch of messages
+      std::ofstream file_;
+      std::thread thread_;
+  };
+
+  /// Limit the emission rate of a given message
+  /// \note To be declared as a static object at the call site, e.g.
+  ///  \code
+  ///  static LogRateLimiter limiter( std::chrono::seconds( 1 ) );
+  ///  IVUTILS_LOG( info, limiter ) << ...;
+  ///  \endcode
+  class LogRateLimiter
   {
     public:
-      LogMessage( const LogMessageType& type ) : type_( type ) {}
-      ~LogMessage() {
-        switch ( type_ ) {
-          case error: std::cout << "[ERROR]"; break;
-          case warning: std::cout << "[WARNING]"; break;
-          case info: std::cout << "[INFO]"; break;
+      explicit LogRateLimiter( const std::chrono::steady_clock::duration& interval ) :
+        interval_( interval.count() ), next_( 0 ), num_suppressed_( 0 ) {}
+
+      /// Check if a message can be emitted now
+      /// \param[out] num_suppressed Number of messages suppressed since the last emission
+      bool allow( size_t& num_suppressed ) {
+        const long long now = std::chrono::steady_clock::now().time_since_epoch().count();
+        long long next = next_.load( std::memory_order_relaxed );
+        if ( now < next || !next_.compare_exchange_strong( next, now+interval_, std::memory_order_relaxed ) ) {
+          ++num_suppressed_;
+          return false;
         }
-        std::cout << " " << message_.str() << std::endl;
-        if ( type_ == error )
-          exit( 0 );
+        num_suppressed = num_suppressed_.exchange( 0 );
+        return true;
       }
 
+    private:
+      const long long interval_;
+      std::atomic<long long> next_; ///< earliest time for the next emission
+      std::atomic<size_t> num_suppressed_;
+  };
+
+  /// Single message, formatted on the emitting thread
+  /// \note Messages are formatted into a per-thread reusable stream, so that
+  ///  no allocation is performed in the steady state
+  class LogMessage
+  {
+    public:
+      LogMessage( const LogMessageType& type );
+      /// Build a rate-limited message
+      LogMessage( const LogMessageType& type, LogRateLimiter& limiter );
+      LogMessage( const LogMessage& ) = delete;
+      ~LogMessage();
+
       //----- Overloaded stream operators
 
       /// Generic templated message feeder operator
       template<typename T>
       inline friend const LogMessage& operator<<( const LogMessage& msg, T var ) {
-        LogMessage& nc_msg = const_cast<LogMessage&>( msg );
-        nc_msg.message_ << var;
+        if ( msg.message_ )
+          *msg.message_ << var;
         return msg;
       }
       /// Pipe modifier operator
       inline friend const LogMessage& operator<<( const LogMessage& msg, std::ios_base&( *f )( std::ios_base& ) ) {
-        LogMessage& nc_msg = const_cast<LogMessage&>( msg );
-        f( nc_msg.message_ );
+        if ( msg.message_ )
+          f( *msg.message_ );
         return msg;
       }
 
     private:
+      /// Acquire a formatting stream of the current thread
+      void open();
+
       LogMessageType type_;
-      /// Message to log
-      std::ostringstream message_;
+      size_t num_suppressed_;
+      /// Stream the message is formatted into (only set if it is to be emitted)
+      std::ostream* message_;
+  };
 
+  /// Discard the value of a streamed message expression (see IVUTILS_LOG)
+  struct LogVoidify
+  {
+    void operator&( const LogMessage& ) const {}
   };
 }
 
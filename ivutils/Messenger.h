@@ -1,7 +1,10 @@
 #ifndef ivutils_Messenger_h
 #define ivutils_Messenger_h
 
-#include <array>
+#include "ivutils/StringView.h"
+#include "ivutils/IOExecutor.h"
+#include "ivutils/SettingsCache.h"
+
 #include <vector>
 #include <string>
 
@@ -13,38 +16,148 @@ namespace ivutils
 {
   class ParametersList;
   /// Basic communication protocol handler
+  /// \note All operations are run on a dedicated I/O thread; synchronous
+  ///  methods are thin wrappers waiting for the completion of the operation
   class Messenger
   {
     public:
+      /// Strategy used to detect the availability of an answer to a query
+      enum CompletionMode {
+        fixedDelay, ///< wait for a fixed acknowledgement time before reading
+        serialPoll, ///< poll the status byte until the message available (MAV) bit is set
+        serviceRequest ///< wait for the module to assert a service request on MAV
+      };
 //      Messenger() = default;
       /// Build a messenger at a given address
-      explicit Messenger( int prim_addr = -1, int second_addr = 0 );
+      /// \param[in] prim_addr Primary GPIB address of the module
+      /// \param[in] second_addr Secondary GPIB address of the module
+      /// \param[in] board_index Index of the GPIB interface board the module is connected to
+      explicit Messenger( int prim_addr = -1, int second_addr = 0, int board_index = 0 );
       ~Messenger();
 
+      /// Select the query completion strategy
+      /// \param[in] mode Completion detection mode
+      /// \param[in] timeout_ms Default deadline (in ms) for an answer to be made available
+      void setCompletionMode( const CompletionMode& mode, unsigned int timeout_ms = DEFAULT_TIMEOUT_MS );
+      /// Set the maximal length of a single message accepted by the module
+      void setInputBufferSize( size_t size );
       /// Send a message to the module
+      /// \note All pending commands are sent beforehand
       /// \param[in] msg Command to be transmitted
       void send( std::string msg ) const;
+      /// Queue a (non-query) command, to be sent along with the next ones
+      /// \note Consecutive commands are joined into a single message, sent
+      ///  once the module input buffer limit is reached, or before any other
+      ///  message is transmitted
+      /// \param[in] msg Command to be transmitted
+      void queue( const std::string& msg ) const;
+      /// Send all pending commands as a single message
+      void flush() const;
       /// Interrogate the module
       /// \param[in] msg Command to be transmitted
-      std::vector<std::string> fetch( const std::string& msg ) const;
+      /// \param[in] timeout_ms Deadline (in ms) for the answer to be available (0 for the default one)
+      std::vector<std::string> fetch( const std::string& msg, unsigned int timeout_ms = 0 ) const;
+      /// Retrieve the module status byte through a serial poll
+      /// \note Scheduled ahead of all set-point and bulk operations
+      char statusByte() const;
 
-    private:
+      /// Send a message to the module, without waiting for its transmission
+      /// \param[in] msg Command to be transmitted
+      /// \param[in] priority Scheduling priority of the operation
+      /// \param[in] deadline_ms Maximal delay (in ms) before the operation starts (0 for none)
+      std::future<void> sendAsync( const std::string& msg, const IOExecutor::Priority& priority = IOExecutor::setPoint, unsigned int deadline_ms = 0 ) const;
+      /// Interrogate the module, without waiting for its answer
+      /// \param[in] msg Command to be transmitted
+      /// \param[in] timeout_ms Deadline (in ms) for the answer to be available (0 for the default one)
+      /// \param[in] priority Scheduling priority of the operation
+      /// \param[in] deadline_ms Maximal delay (in ms) before the operation starts (0 for none)
+      std::future<std::vector<std::string> > fetchAsync( const std::string& msg, unsigned int timeout_ms = 0, const IOExecutor::Priority& priority = IOExecutor::setPoint, unsigned int deadline_ms = 0 ) const;
+      /// Retrieve the module status byte, without waiting for the serial poll
+      /// \param[in] deadline_ms Maximal delay (in ms) before the operation starts (0 for none)
+      std::future<char> statusByteAsync( unsigned int deadline_ms = 0 ) const;
+
+      /// Parse a completion mode name ("delay", "poll", or "srq")
+      static CompletionMode completionMode( const std::string& name );
+
+    protected:
       static const unsigned short ACK_TIME_MS;
+      static const unsigned int DEFAULT_TIMEOUT_MS;
+      static const size_t DEFAULT_INPUT_BUFFER_SIZE;
+
+      /// Run an operation on the I/O thread, and wait for its result
+      /// \note The operation is run immediately if called from the I/O thread
+      /// \param[in] ordered Operation may depend on the module state left by earlier ones
+      ///  (e.g. its trigger model), and is never to overtake them
+      template<typename F> typename std::result_of<F()>::type execute( F&& operation, const IOExecutor::Priority& priority = IOExecutor::setPoint, bool ordered = true ) const {
+        if ( executor_.inWorkerThread() )
+          return operation();
+        return executor_.submit( std::forward<F>( operation ), priority, IOExecutor::Clock::time_point::max(), ordered ).get();
+      }
+      /// Queue an operation on the I/O thread
+      /// \param[in] deadline_ms Maximal delay (in ms) before the operation starts (0 for none)
+      /// \warning The result is not to be waited for from the I/O thread itself
+      template<typename F> std::future<typename std::result_of<F()>::type> executeAsync( F&& operation, const IOExecutor::Priority& priority = IOExecutor::setPoint, unsigned int deadline_ms = 0, bool ordered = true ) const {
+        return executor_.submit( std::forward<F>( operation ), priority, deadline_ms > 0
+          ? IOExecutor::Clock::now()+std::chrono::milliseconds( deadline_ms )
+          : IOExecutor::Clock::time_point::max(), ordered );
+      }
+
+      /// Shadow model of all settings transmitted to the module
+      /// \note Only to be accessed from the I/O thread
+      SettingsCache& settings() const { return settings_; }
+
+      //--- zero-copy queries; the answer buffer is only to be accessed from the I/O thread
+
+      /// Interrogate the module without copying its answer
+      /// \param[in] msg Command to be transmitted
+      /// \param[out] lines Views on all lines of the answer, only valid on the I/O thread, until the next query
+      /// \param[in] timeout_ms Deadline (in ms) for the answer to be available (0 for the default one)
+      void fetch( const std::string& msg, std::vector<StringView>& lines, unsigned int timeout_ms = 0 ) const;
+      /// Interrogate the module and retrieve its raw answer
+      /// \param[in] msg Command to be transmitted
+      /// \param[in] timeout_ms Deadline (in ms) for the answer to be available (0 for the default one)
+      /// \return View on the full answer (binary content included), only valid on the I/O thread, until the next query
+      StringView fetchRaw( const std::string& msg, unsigned int timeout_ms = 0 ) const;
+
+    private:
+      /// Status byte bit indicating a message is available in the output queue
+      static const char STB_MAV;
+      /// Interval between two consecutive serial polls
+      static const unsigned short POLL_INTERVAL_US;
+      /// Minimal free space in the receive buffer for each read
+      static const size_t READ_CHUNK_SIZE;
       void clear() const;
-      /// Retrieve data from the module
-      std::vector<std::string> receive() const;
+      /// Transmit a message to the module
+      void write( const std::string& msg ) const;
+      /// Block until an answer is available from the module
+      /// \param[in] timeout_ms Maximal time (in ms) to wait for the answer
+      void waitForAnswer( unsigned int timeout_ms ) const;
+      /// Retrieve the status byte through a serial poll
+      char serialPollByte() const;
+      /// Retrieve data from the module into the receive buffer
+      /// \param[in] timeout_ms Maximal time (in ms) for the answer to be read (0 for the default I/O timeout)
+      /// \return Number of bytes received
+      size_t receive( unsigned int timeout_ms = 0 ) const;
 
 #if defined EMULATE
       mutable std::ofstream cmd_file_;
 #endif
-      mutable std::string last_command_;
+      mutable SettingsCache settings_;
+      mutable std::string pending_commands_; ///< joined commands waiting to be sent
+      size_t input_buffer_size_;
 
       std::vector<std::string> configCommands_;
       std::vector<std::string> operationCommands_;
       std::vector<std::string> closingCommands_;
       // device handlers
       int device_; ///< Device descriptor
-      std::array<char,100> buffer_;
+      CompletionMode completion_mode_;
+      unsigned int timeout_ms_; ///< default query deadline (in ms)
+      /// Receive buffer, grown on demand and reused for all reads
+      /// \note Only accessed from the I/O thread
+      mutable std::vector<char> buffer_;
+      /// I/O thread for all operations on this module (stopped first)
+      mutable IOExecutor executor_;
   };
 }
 
@@ -0,0 +1,60 @@
+#ifndef ivutils_OutputSink_h
+#define ivutils_OutputSink_h
+
+#include "ivutils/Reading.h"
+
+#include <vector>
+
+namespace ivutils
+{
+  /// Consumer of all quantities measured by the stations
+  /// \note Methods are called from the stations threads, concurrently for
+  ///  different stations; implementations are to be thread-safe
+  class OutputSink
+  {
+    public:
+      virtual ~OutputSink() = default;
+
+      /// Add a raw reading
+      /// \param[in] station Station index
+      /// \param[in] stage Voltage stage index
+      /// \param[in] voltage Voltage set for this stage
+      /// \param[in] reading Reading, as retrieved from the ammeter
+      virtual void addReading( unsigned short /*station*/, unsigned short /*stage*/, double /*voltage*/, const Reading& /*reading*/ ) {}
+      /// Add the summary of a voltage stage
+      virtual void addStage( unsigned short /*station*/, unsigned short /*stage*/, double /*voltage*/, double /*mean*/, double /*stdev*/, unsigned int /*num_readings*/ ) {}
+      /// Add a current measured during the stability test
+      /// \param[in] time Time since the beginning of the stability test (in s)
+      virtual void addStabilityPoint( unsigned short /*station*/, double /*time*/, double /*current*/ ) {}
+  };
+
+  /// Forward all quantities to a list of output sinks
+  class MultiOutput : public OutputSink
+  {
+    public:
+      /// Add an output sink to the list
+      /// \note The sink must outlive this object
+      MultiOutput& add( OutputSink& sink ) {
+        sinks_.emplace_back( &sink );
+        return *this;
+      }
+
+      void addReading( unsigned short station, unsigned short stage, double voltage, const Reading& reading ) override {
+        for ( auto& sink : sinks_ )
+          sink->addReading( station, stage, voltage, reading );
+      }
+      void addStage( unsigned short station, unsigned short stage, double voltage, double mean, double stdev, unsigned int num_readings ) override {
+        for ( auto& sink : sinks_ )
+          sink->addStage( station, stage, voltage, mean, stdev, num_readings );
+      }
+      void addStabilityPoint( unsigned short station, double time, double current ) override {
+        for ( auto& sink : sinks_ )
+          sink->addStabilityPoint( station, time, current );
+      }
+
+    private:
+      std::vector<OutputSink*> sinks_;
+  };
+}
+
+#endif
@@ -1,105 +1,202 @@
 #ifndef ivutils_ParametersList_h
 #define ivutils_ParametersList_h
 
+#include "ivutils/StringView.h"
+#include "ivutils/Utils.h"
+
 #include <string>
 #include <vector>
-#include <map>
+#include <memory>
 #include <unordered_map>
+#include <stdexcept>
 
 /// Unique namespace for all utilitaries
 namespace ivutils
 {
+  class ParametersList;
+  /// Type returned when retrieving a parameter value
+  /// \note Scalars are returned by value, all other types by reference to the stored value
+  template<typename T> struct ParameterRef { typedef const T& type; };
+  template<> struct ParameterRef<int> { typedef int type; };
+  template<> struct ParameterRef<bool> { typedef bool type; };
+  template<> struct ParameterRef<double> { typedef double type; };
+
   /// Parameters container
+  /// \note All values are held in a single flat list, indexed by their (interned)
+  ///  key; non-scalar values are immutable once set, and shared between copies.
+  ///  The list itself is copied on write: copies (e.g. configuration snapshots)
+  ///  are cheap, and share all their content until one of them is modified
   class ParametersList
   {
     public:
+      /// Type of a stored value
+      enum Type {
+        invalid,
+        integer, real, string, params,
+        vec_integer, vec_real, vec_string, vec_params
+      };
+
       ParametersList() = default;
       ~ParametersList() = default; // required for unique_ptr initialisation!
       /// Check if a given parameter is handled in this list
-      template<typename T> bool hasParameter( std::string key ) const;
+      template<typename T> bool hasParameter( const StringView& key ) const;
       /// Get a parameter value
-      template<typename T> T getParameter( std::string key ) const;
+      /// \note No allocation is involved in the lookup
+      template<typename T> typename ParameterRef<T>::type getParameter( const StringView& key ) const;
       /// Set a parameter value
-      template<typename T> ParametersList& set( std::string key, const T& value );
+      template<typename T> ParametersList& set( const StringView& key, const T& value );
+      /// Set a parameter value in a nested parameters list
+      /// \note Only the lists along the path are copied, all others are shared
+      /// \param[in] path Dot-separated path to the parameter (e.g. "vsource.address")
+      template<typename T> ParametersList& setPath( const StringView& path, const T& value );
       /// Concatenate two parameters containers
+      /// \note Parameters already set in this list are kept
       ParametersList& operator+=( const ParametersList& oth );
+      /// Check if two lists share the same content (without comparing the values)
+      bool shares( const ParametersList& oth ) const { return node_ == oth.node_; }
 
+      /// Check if no parameter is handled in this list
+      bool empty() const { return !node_ || node_->values.empty(); }
       /// List of keys handled in this list of parameters
       std::vector<std::string> keys() const;
+      /// Type of a parameter value (invalid if not handled)
+      Type type( const StringView& key ) const;
       /// Get a string-converted version of a value
-      std::string getString( const std::string& key ) const;
+      std::string getString( const StringView& key ) const;
 
       /// Human-readable version of a parameters container
       friend std::ostream& operator<<( std::ostream& os, const ParametersList& );
 
     private:
-      std::map<std::string,ParametersList> param_values_;
-      std::unordered_map<std::string,int> int_values_;
-      std::unordered_map<std::string,double> dbl_values_;
-      std::unordered_map<std::string,std::string> str_values_;
-      std::unordered_map<std::string,std::vector<ParametersList> > vec_param_values_;
-      std::unordered_map<std::string,std::vector<int> > vec_int_values_;
-      std::unordered_map<std::string,std::vector<double> > vec_dbl_values_;
-      std::unordered_map<std::string,std::vector<std::string> > vec_str_values_;
+      /// Unique, never freed, copy of a key
+      static const std::string& intern( const StringView& key );
+      /// Hash of a key view
+      struct KeyHash
+      {
+        size_t operator()( const StringView& key ) const { return fnv1a( key ); }
+      };
+      /// Stored value
+      struct Value
+      {
+        const std::string* key; ///< interned key
+        Type type;
+        union {
+          int integer;
+          double real;
+        };
+        std::shared_ptr<const void> object; ///< non-scalar value (immutable)
+      };
+      /// Retrieve a value of a given type
+      /// \return Null if the key is not handled, or holds another type
+      const Value* find( const StringView& key, const Type& type ) const;
+      /// Retrieve a value slot for a key, created if needed
+      /// \note The list content is detached from all its copies beforehand
+      Value& slot( const StringView& key );
+      /// Retrieve a non-scalar value of a given type
+      template<typename T> const T& object( const StringView& key, const Type& type ) const;
+      /// Set a non-scalar value of a given type
+      template<typename T> ParametersList& setObject( const StringView& key, const Type& type, const T& value );
+      /// Content of a list, shared between its copies
+      struct Node
+      {
+        std::vector<Value> values; ///< all values, in insertion order
+        std::unordered_map<StringView,size_t,KeyHash> index; ///< position of each value, from its (interned) key
+      };
+      /// Content of this list (if not empty)
+      /// \note Never modified while shared with another list
+      std::shared_ptr<Node> node_;
   };
+
+  //--- generic accessors
+
+  template<typename T> ParametersList&
+  ParametersList::setPath( const StringView& path, const T& value )
+  {
+    const size_t pos = path.find( '.' );
+    if ( pos == std::string::npos )
+      return set<T>( path, value );
+    const StringView key = path.substr( 0, pos );
+    ParametersList sub = hasParameter<ParametersList>( key ) ? getParameter<ParametersList>( key ) : ParametersList();
+    sub.setPath<T>( path.substr( pos+1 ), value );
+    return set<ParametersList>( key, sub );
+  }
+
+  template<typename T> const T&
+  ParametersList::object( const StringView& key, const Type& type ) const
+  {
+    const Value* value = find( key, type );
+    if ( !value )
+      throw std::runtime_error( "Failed to retrieve parameter with key="+key.str()+"!" );
+    return *static_cast<const T*>( value->object.get() );
+  }
+
+  template<typename T> ParametersList&
+  ParametersList::setObject( const StringView& key, const Type& type, const T& value )
+  {
+    Value& val = slot( key );
+    val.type = type;
+    val.object = std::make_shared<T>( value );
+    return *this;
+  }
+
   /// Check if an integer parameter is handled
-  template<> inline bool ParametersList::hasParameter<int>( std::string key ) const { return int_values_.count( key ) != 0; }
+  template<> inline bool ParametersList::hasParameter<int>( const StringView& key ) const { return find( key, integer ) != nullptr; }
   /// Get an integer parameter value
-  template<> int ParametersList::getParameter<int>( std::string key ) const;
+  template<> int ParametersList::getParameter<int>( const StringView& key ) const;
   /// Set an integer parameter value
-  template<> inline ParametersList& ParametersList::set<int>( std::string key, const int& value ) { int_values_[key] = value; return *this; }
+  template<> inline ParametersList& ParametersList::set<int>( const StringView& key, const int& value ) { Value& val = slot( key ); val.type = integer; val.integer = value; val.object.reset(); return *this; }
   /// Check if a vector of integers parameter is handled
-  template<> inline bool ParametersList::hasParameter<std::vector<int> >( std::string key ) const { return vec_int_values_.count( key ) != 0; }
+  template<> inline bool ParametersList::hasParameter<std::vector<int> >( const StringView& key ) const { return find( key, vec_integer ) != nullptr; }
   /// Get a vector of integers parameter value
-  template<> std::vector<int> ParametersList::getParameter<std::vector<int> >( std::string key ) const;
+  template<> inline const std::vector<int>& ParametersList::getParameter<std::vector<int> >( const StringView& key ) const { return object<std::vector<int> >( key, vec_integer ); }
   /// Set a vector of integers parameter value
-  template<> inline ParametersList& ParametersList::set<std::vector<int> >( std::string key, const std::vector<int>& value ) { vec_int_values_[key] = value; return *this; }
+  template<> inline ParametersList& ParametersList::set<std::vector<int> >( const StringView& key, const std::vector<int>& value ) { return setObject( key, vec_integer, value ); }
 
   /// Check if a boolean parameter is handled
-  template<> inline bool ParametersList::hasParameter<bool>( std::string key ) const { return hasParameter<int>( key ); }
+  template<> inline bool ParametersList::hasParameter<bool>( const StringView& key ) const { return hasParameter<int>( key ); }
   /// Get a boolean parameter value
-  template<> inline bool ParametersList::getParameter<bool>( std::string key ) const { return static_cast<bool>( getParameter<int>( key ) ); }
+  template<> inline bool ParametersList::getParameter<bool>( const StringView& key ) const { return static_cast<bool>( getParameter<int>( key ) ); }
   /// Set a boolean parameter value
-  template<> inline ParametersList& ParametersList::set<bool>( std::string key, const bool& value ) { return set<int>( key, static_cast<bool>( value ) ); }
+  template<> inline ParametersList& ParametersList::set<bool>( const StringView& key, const bool& value ) { return set<int>( key, static_cast<bool>( value ) ); }
 
   /// Check if a double floating point parameter is handled
-  template<> inline bool ParametersList::hasParameter<double>( std::string key ) const { return dbl_values_.count( key ) != 0; }
+  template<> inline bool ParametersList::hasParameter<double>( const StringView& key ) const { return find( key, real ) != nullptr; }
   /// Get a double floating point parameter value
-  template<> double ParametersList::getParameter<double>( std::string key ) const;
+  template<> double ParametersList::getParameter<double>( const StringView& key ) const;
   /// Set a double floating point parameter value
-  template<> inline ParametersList& ParametersList::set<double>( std::string key, const double& value ) { dbl_values_[key] = value; return *this; }
+  template<> inline ParametersList& ParametersList::set<double>( const StringView& key, const double& value ) { Value& val = slot( key ); val.type = real; val.real = value; val.object.reset(); return *this; }
   /// Check if a vector of double floating point parameter is handled
-  template<> inline bool ParametersList::hasParameter<std::vector<double> >( std::string key ) const { return vec_dbl_values_.count( key ) != 0; }
+  template<> inline bool ParametersList::hasParameter<std::vector<double> >( const StringView& key ) const { return find( key, vec_real ) != nullptr; }
   /// Get a vector of double floating point parameter value
-  template<> std::vector<double> ParametersList::getParameter<std::vector<double> >( std::string key ) const;
+  template<> inline const std::vector<double>& ParametersList::getParameter<std::vector<double> >( const StringView& key ) const { return object<std::vector<double> >( key, vec_real ); }
   /// Set a vector of double floating point parameter value
-  template<> inline ParametersList& ParametersList::set<std::vector<double> >( std::string key, const std::vector<double>& value ) { vec_dbl_values_[key] = value; return *this; }
+  template<> inline ParametersList& ParametersList::set<std::vector<double> >( const StringView& key, const std::vector<double>& value ) { return setObject( key, vec_real, value ); }
 
   /// Check if a string parameter is handled
-  template<> inline bool ParametersList::hasParameter<std::string>( std::string key ) const { return str_values_.count( key ) != 0; }
+  template<> inline bool ParametersList::hasParameter<std::string>( const StringView& key ) const { return find( key, string ) != nullptr; }
   /// Get a string parameter value
-  template<> std::string ParametersList::getParameter<std::string>( std::string key ) const;
+  template<> inline const std::string& ParametersList::getParameter<std::string>( const StringView& key ) const { return object<std::string>( key, string ); }
   /// Set a string parameter value
-  template<> inline ParametersList& ParametersList::set<std::string>( std::string key, const std::string& value ) { str_values_[key] = value; return *this; }
+  template<> inline ParametersList& ParametersList::set<std::string>( const StringView& key, const std::string& value ) { return setObject( key, string, value ); }
   /// Check if a vector of strings parameter is handled
-  template<> inline bool ParametersList::hasParameter<std::vector<std::string> >( std::string key ) const { return vec_str_values_.count( key ) != 0; }
+  template<> inline bool ParametersList::hasParameter<std::vector<std::string> >( const StringView& key ) const { return find( key, vec_string ) != nullptr; }
   /// Get a vector of strings parameter value
-  template<> std::vector<std::string> ParametersList::getParameter<std::vector<std::string> >( std::string key ) const;
+  template<> inline const std::vector<std::string>& ParametersList::getParameter<std::vector<std::string> >( const StringView& key ) const { return object<std::vector<std::string> >( key, vec_string ); }
   /// Set a vector of strings parameter value
-  template<> inline ParametersList& ParametersList::set<std::vector<std::string> >( std::string key, const std::vector<std::string>& value ) { vec_str_values_[key] = value; return *this; }
+  template<> inline ParametersList& ParametersList::set<std::vector<std::string> >( const StringView& key, const std::vector<std::string>& value ) { return setObject( key, vec_string, value ); }
 
   /// Check if a parameters list parameter is handled
-  template<> inline bool ParametersList::hasParameter<ParametersList>( std::string key ) const { return param_values_.count( key ) != 0; }
+  template<> inline bool ParametersList::hasParameter<ParametersList>( const StringView& key ) const { return find( key, params ) != nullptr; }
   /// Get a parameters list parameter value
-  template<> ParametersList ParametersList::getParameter<ParametersList>( std::string key ) const;
+  template<> inline const ParametersList& ParametersList::getParameter<ParametersList>( const StringView& key ) const { return object<ParametersList>( key, params ); }
   /// Set a parameters list parameter value
-  template<> inline ParametersList& ParametersList::set<ParametersList>( std::string key, const ParametersList& value ) { param_values_[key] = value; return *this; }
+  template<> inline ParametersList& ParametersList::set<ParametersList>( const StringView& key, const ParametersList& value ) { return setObject( key, params, value ); }
   /// Check if a vector of parameters lists is handled
-  template<> inline bool ParametersList::hasParameter<std::vector<ParametersList> >( std::string key ) const { return vec_param_values_.count( key ) != 0; }
+  template<> inline bool ParametersList::hasParameter<std::vector<ParametersList> >( const StringView& key ) const { return find( key, vec_params ) != nullptr; }
   /// Get a vector of parameters list parameter value
-  template<> std::vector<ParametersList> ParametersList::getParameter<std::vector<ParametersList> >( std::string key ) const;
+  template<> inline const std::vector<ParametersList>& ParametersList::getParameter<std::vector<ParametersList> >( const StringView& key ) const { return object<std::vector<ParametersList> >( key, vec_params ); }
   /// Set a vector of parameters list parameter value
-  template<> inline ParametersList& ParametersList::set<std::vector<ParametersList> >( std::string key, const std::vector<ParametersList>& value ) { vec_param_values_[key] = value; return *this; }
+  template<> inline ParametersList& ParametersList::set<std::vector<ParametersList> >( const StringView& key, const std::vector<ParametersList>& value ) { return setObject( key, vec_params, value ); }
 }
 
 #endif
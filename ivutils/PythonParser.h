@@ -21,6 +21,8 @@ namespace ivutils
       static std::string pythonPath( const char* file );
       static PyObject* encode( const char* str );
       static PyObject* extract( PyObject*, const char* key );
+      /// Source files of all modules imported by the card, outside of the Python installation
+      std::vector<std::string> importedFiles() const;
 
       template<typename T> bool is( PyObject* obj ) const;
       template<typename T> T get( PyObject* obj ) const;
@@ -0,0 +1,67 @@
+#ifndef ivutils_Reading_h
+#define ivutils_Reading_h
+
+#include "ivutils/StringView.h"
+
+#include <vector>
+#include <string>
+
+namespace ivutils
+{
+  /// Single reading from an instrument
+  struct Reading
+  {
+    Reading() : value( 0. ), timestamp( 0. ), status( 0 ), voltage( 0. ) {}
+    double value; ///< measured quantity (current, voltage, ...)
+    double timestamp; ///< instrument timestamp (in s)
+    unsigned long status; ///< instrument status word
+    double voltage; ///< source voltage (in V)
+  };
+
+  /// Parser for the readings transmitted by an instrument
+  class ReadingParser
+  {
+    public:
+      /// Data element of a reading, as transmitted by the instrument
+      enum Element { measurement, time, status, sourceVoltage, ignored };
+
+      /// Build a parser for (measurement, timestamp) readings
+      ReadingParser();
+      /// Build a parser from the list of elements transmitted (as in the :FORM:ELEM command)
+      /// \param[in] names Elements names (e.g. "READ", "TIME", "STAT", "VSO")
+      explicit ReadingParser( const std::vector<std::string>& names );
+
+      /// Comma-separated list of elements, as expected by the :FORM:ELEM command
+      const std::string& elementsList() const { return elements_list_; }
+      /// Number of elements transmitted for each reading
+      size_t numElements() const { return elements_.size(); }
+
+      /// Parse all readings of an ASCII answer, in a single pass
+      /// \note Unit suffixes (e.g. "A", "V") are skipped
+      /// \param[in] answer Raw answer from the instrument
+      /// \param[out] readings List of readings to be filled
+      /// \return Number of readings parsed
+      size_t parse( const StringView& answer, std::vector<Reading>& readings ) const;
+      /// Parse a flat list of comma-separated values from an ASCII answer
+      /// \param[in] answer Raw answer from the instrument
+      /// \param[out] values Caller-supplied array of values to be filled
+      /// \param[in] max_values Capacity of the array
+      /// \return Number of values parsed
+      static size_t parseValues( const StringView& answer, double* values, size_t max_values );
+      /// Group a flat list of (binary-transferred) values into readings
+      /// \param[in] values Array of values
+      /// \param[in] num_values Number of values in the array
+      /// \param[out] readings List of readings to be filled
+      /// \return Number of readings filled
+      size_t fill( const double* values, size_t num_values, std::vector<Reading>& readings ) const;
+
+    private:
+      /// Store a value in its reading field
+      void setElement( Reading& reading, size_t index, double value ) const;
+
+      std::vector<Element> elements_;
+      std::string elements_list_;
+  };
+}
+
+#endif
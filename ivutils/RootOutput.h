@@ -0,0 +1,70 @@
+#ifndef ivutils_RootOutput_h
+#define ivutils_RootOutput_h
+
+#include "ivutils/OutputSink.h"
+#include "ivutils/History.h"
+
+#include "TGraphErrors.h"
+
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+
+class TFile;
+class TTree;
+
+namespace ivutils
+{
+  /// Streaming output of all readings into a ROOT file
+  /// \note Readings are appended to a tree as soon as they are acquired, and
+  ///  the tree is regularly saved, so that data already acquired survive a crash;
+  ///  the I-V and stability test curves are written at the end of the scan, the
+  ///  latter as a bounded-size summary (full-resolution currents are in the tree);
+  ///  the output has its own lock, never shared with the graphical interface
+  class RootOutput : public OutputSink
+  {
+    public:
+      /// Open an output file
+      /// \param[in] filename Output file path
+      /// \param[in] stations Names of all stations (empty for a single-station setup)
+      /// \param[in] autosave_interval Maximal time between two saves of the trees on disk
+      RootOutput( const std::string& filename, const std::vector<std::string>& stations,
+                  const std::chrono::seconds& autosave_interval = DEFAULT_AUTOSAVE_INTERVAL );
+      /// Save all trees, and close the file
+      ~RootOutput();
+
+      void addReading( unsigned short station, unsigned short stage, double voltage, const Reading& reading ) override;
+      void addStage( unsigned short station, unsigned short stage, double voltage, double mean, double stdev, unsigned int num_readings ) override;
+      void addStabilityPoint( unsigned short station, double time, double current ) override;
+      /// Output file, e.g. to store additional objects
+      /// \note Only to be accessed once no more readings are added
+      TFile* file() const { return file_.get(); }
+
+    private:
+      static const std::chrono::seconds DEFAULT_AUTOSAVE_INTERVAL;
+      /// Number of bytes buffered in memory before the tree baskets are written
+      static const long long AUTOFLUSH_BYTES;
+      /// Save the trees if the last save is too old (output lock to be held)
+      void autoSave();
+
+      std::unique_ptr<TFile> file_;
+      std::mutex mutex_; ///< serialises all operations on the output objects
+      std::chrono::steady_clock::duration autosave_interval_;
+      std::chrono::steady_clock::time_point last_save_;
+      const std::chrono::system_clock::time_point start_;
+      TTree* readings_; ///< raw readings tree (owned by the file)
+      TTree* stages_; ///< voltage stages summary tree (owned by the file)
+      std::vector<TGraphErrors> gr_meas_; ///< I-V curve, for each station
+      std::vector<TGraphErrors> gr_stability_vs_time_; ///< current versus time in the stability test, for each station
+      std::vector<History> stability_history_; ///< bounded-memory history of the stability test, for each station
+      //--- tree branches content
+      unsigned short station_, stage_;
+      double voltage_, time_, timestamp_, current_, stdev_;
+      unsigned long long status_;
+      unsigned int num_readings_;
+  };
+}
+
+#endif
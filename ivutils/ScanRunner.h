@@ -0,0 +1,64 @@
+#ifndef ivutils_ScanRunner_h
+#define ivutils_ScanRunner_h
+
+#include "ivutils/ParametersList.h"
+#include "ivutils/Station.h"
+
+#include <functional>
+#include <memory>
+#include <chrono>
+
+namespace ivutils
+{
+  class OutputSink;
+  /// Steering of all measurement stations of a configuration card
+  /// \note No graphical interface is involved; an idle callback is called
+  ///  regularly from the calling thread while the stations are running
+  class ScanRunner
+  {
+    public:
+      /// Operation called from the steering thread while the stations are running
+      typedef std::function<void()> IdleCallback;
+
+      /// Build all stations from a configuration card
+      /// \param[in] config_file Path to the card (JSON if its extension is ".json", Python otherwise)
+      explicit ScanRunner( const char* config_file );
+
+      /// Parse a configuration card
+      /// \param[in] config_file Path to the card (JSON if its extension is ".json", Python otherwise)
+      static ParametersList parseCard( const char* config_file );
+
+      /// Set the operation called while the stations are running
+      /// \param[in] callback Operation to be called
+      /// \param[in] interval Interval between two calls
+      void setIdleCallback( const IdleCallback& callback, const std::chrono::milliseconds& interval = DEFAULT_IDLE_INTERVAL );
+
+      void configure() const;
+      void rampDown() const;
+      /// Perform a full I-V scan on all stations
+      /// \param[in] output Output for all quantities measured
+      void scan( OutputSink& output ) const;
+      /// Perform a quick acquisition on the first station
+      /// \param[in] output Output for all readings
+      void test( OutputSink& output ) const;
+
+      /// Number of measurement stations
+      size_t numStations() const { return stations_.size(); }
+      /// Names of all measurement stations (empty for a single-station setup)
+      std::vector<std::string> stationNames() const;
+
+    private:
+      static const std::chrono::milliseconds DEFAULT_IDLE_INTERVAL;
+      /// Run an operation concurrently on all stations, each in its own thread
+      /// \param[in] operation Operation to run, given a station and its index
+      void runOnAllStations( const std::function<void( const Station&, size_t )>& operation ) const;
+
+      ParametersList params_; ///< full configuration
+      /// List of measurement stations (one voltage source and ammeter pair each)
+      std::vector<std::unique_ptr<Station> > stations_;
+      IdleCallback idle_callback_;
+      std::chrono::milliseconds idle_interval_;
+  };
+}
+
+#endif
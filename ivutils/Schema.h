@@ -0,0 +1,225 @@
+#ifndef ivutils_Schema_h
+#define ivutils_Schema_h
+
+#include "ivutils/ParametersList.h"
+
+#include <ostream>
+#include <sstream>
+#include <limits>
+#include <memory>
+
+namespace ivutils
+{
+  /// Conversion rules between a parameters list and a typed value
+  template<typename T> struct SchemaValue
+  {
+    static const char* name();
+    /// Retrieve a value from a list
+    /// \return False if the key is not handled
+    /// \throw std::runtime_error if the key holds an incompatible type
+    static bool get( const ParametersList& params, const StringView& key, T& value ) {
+      if ( params.type( key ) == ParametersList::invalid )
+        return false;
+      if ( !params.hasParameter<T>( key ) )
+        throw std::runtime_error( "invalid type for parameter \""+key.str()+"\": expecting "+name() );
+      value = params.getParameter<T>( key );
+      return true;
+    }
+    static void print( std::ostream& os, const T& value ) { os << value; }
+  };
+  template<> inline const char* SchemaValue<int>::name() { return "int"; }
+  template<> inline const char* SchemaValue<bool>::name() { return "bool"; }
+  template<> inline const char* SchemaValue<std::string>::name() { return "string"; }
+  template<> inline const char* SchemaValue<ParametersList>::name() { return "param"; }
+  template<> inline void SchemaValue<ParametersList>::print( std::ostream& os, const ParametersList& value ) { os << "{" << value << "}"; }
+
+  /// Floating point values may also be given as integers
+  template<> struct SchemaValue<double>
+  {
+    static const char* name() { return "double"; }
+    static bool get( const ParametersList& params, const StringView& key, double& value ) {
+      if ( params.hasParameter<int>( key ) ) {
+        value = params.getParameter<int>( key );
+        return true;
+      }
+      if ( params.type( key ) == ParametersList::invalid )
+        return false;
+      if ( !params.hasParameter<double>( key ) )
+        throw std::runtime_error( "invalid type for parameter \""+key.str()+"\": expecting "+name() );
+      value = params.getParameter<double>( key );
+      return true;
+    }
+    static void print( std::ostream& os, const double& value ) { os << value; }
+  };
+
+  /// Collections of values
+  template<typename T> struct SchemaValue<std::vector<T> >
+  {
+    static const char* name();
+    static bool get( const ParametersList& params, const StringView& key, std::vector<T>& value ) {
+      if ( params.type( key ) == ParametersList::invalid )
+        return false;
+      if ( !params.hasParameter<std::vector<T> >( key ) )
+        throw std::runtime_error( "invalid type for parameter \""+key.str()+"\": expecting "+name() );
+      value = params.getParameter<std::vector<T> >( key );
+      return true;
+    }
+    static void print( std::ostream& os, const std::vector<T>& value ) {
+      bool first = true;
+      for ( const auto& v : value ) {
+        os << ( first ? "" : ", " );
+        SchemaValue<T>::print( os, v );
+        first = false;
+      }
+    }
+  };
+  template<> inline const char* SchemaValue<std::vector<int> >::name() { return "vint"; }
+  template<> inline const char* SchemaValue<std::vector<std::string> >::name() { return "vstring"; }
+  template<> inline const char* SchemaValue<std::vector<ParametersList> >::name() { return "vparam"; }
+  template<> inline const char* SchemaValue<std::vector<double> >::name() { return "vdouble"; }
+  /// Floating point values may also be given as integers (e.g. a Python range)
+  template<> inline bool SchemaValue<std::vector<double> >::get( const ParametersList& params, const StringView& key, std::vector<double>& value ) {
+    if ( params.hasParameter<std::vector<int> >( key ) ) {
+      const auto& list = params.getParameter<std::vector<int> >( key );
+      value.assign( list.begin(), list.end() );
+      return true;
+    }
+    if ( params.type( key ) == ParametersList::invalid )
+      return false;
+    if ( !params.hasParameter<std::vector<double> >( key ) )
+      throw std::runtime_error( "invalid type for parameter \""+key.str()+"\": expecting "+name() );
+    value = params.getParameter<std::vector<double> >( key );
+    return true;
+  }
+
+  /// Check a value against an allowed range
+  /// \note Only numerical values (or collections of) are checked
+  template<typename T> inline bool inRange( const T&, double, double ) { return true; }
+  template<> inline bool inRange<int>( const int& value, double min, double max ) { return value >= min && value <= max; }
+  template<> inline bool inRange<double>( const double& value, double min, double max ) { return value >= min && value <= max; }
+  template<> inline bool inRange<std::vector<int> >( const std::vector<int>& value, double min, double max ) {
+    for ( const auto& v : value )
+      if ( !inRange( v, min, max ) )
+        return false;
+    return true;
+  }
+  template<> inline bool inRange<std::vector<double> >( const std::vector<double>& value, double min, double max ) {
+    for ( const auto& v : value )
+      if ( !inRange( v, min, max ) )
+        return false;
+    return true;
+  }
+
+  /// Common definitions of all schemas
+  class SchemaBase
+  {
+    public:
+      /// Value used for an unbounded range
+      static constexpr double UNBOUNDED = std::numeric_limits<double>::infinity();
+  };
+
+  /// Description of all parameters of a settings structure
+  /// \note Parameters are validated and bound to the structure members once,
+  ///  at load time; all errors are reported at once
+  /// \tparam S Settings structure
+  template<typename S> class Schema : public SchemaBase
+  {
+    public:
+      /// Add a parameter which must be specified
+      /// \param[in] key Parameter key
+      /// \param[in] member Structure member the value is bound to
+      /// \param[in] description Human-readable description of the parameter
+      template<typename T> Schema& required( const char* key, T S::* member, const char* description ) {
+        fields_.emplace_back( new Field<T>( key, member, description, true, T() ) );
+        return *this;
+      }
+      /// Add a parameter which may be specified
+      /// \param[in] def Default value
+      template<typename T> Schema& optional( const char* key, T S::* member, const T& def, const char* description ) {
+        fields_.emplace_back( new Field<T>( key, member, description, false, def ) );
+        return *this;
+      }
+      /// Restrict the values of the last parameter added
+      Schema& range( double min, double max = UNBOUNDED ) {
+        if ( fields_.empty() )
+          throw std::runtime_error( "Schema: no parameter to restrict!" );
+        fields_.back()->min = min;
+        fields_.back()->max = max;
+        return *this;
+      }
+
+      /// Validate a list of parameters, and bind it to a new settings structure
+      /// \note Parameters not described in the schema are ignored
+      /// \throw std::runtime_error listing all missing or invalid parameters
+      S bind( const ParametersList& params ) const {
+        S out;
+        std::ostringstream errors;
+        for ( const auto& field : fields_ ) {
+          try {
+            field->bind( params, out );
+          } catch ( const std::runtime_error& err ) {
+            errors << "\n  " << err.what();
+          }
+        }
+        if ( !errors.str().empty() )
+          throw std::runtime_error( "Invalid configuration:"+errors.str() );
+        return out;
+      }
+      /// Human-readable version of a settings structure
+      void dump( std::ostream& os, const S& settings ) const {
+        for ( const auto& field : fields_ )
+          field->dump( os, settings );
+      }
+      std::string dump( const S& settings ) const {
+        std::ostringstream os;
+        dump( os, settings );
+        return os.str();
+      }
+
+    private:
+      /// Untyped parameter description
+      struct FieldBase
+      {
+        FieldBase( const char* key, const char* description, bool required ) :
+          key( key ), description( description ), required( required ), min( -UNBOUNDED ), max( UNBOUNDED ) {}
+        virtual ~FieldBase() = default;
+        virtual void bind( const ParametersList& params, S& settings ) const = 0;
+        virtual void dump( std::ostream& os, const S& settings ) const = 0;
+        const char* key;
+        const char* description;
+        bool required;
+        double min, max;
+      };
+      /// Typed parameter description
+      template<typename T> struct Field : FieldBase
+      {
+        Field( const char* key, T S::* member, const char* description, bool required, const T& def ) :
+          FieldBase( key, description, required ), member( member ), def( def ) {}
+        void bind( const ParametersList& params, S& settings ) const override {
+          T& value = settings.*member;
+          if ( !SchemaValue<T>::get( params, this->key, value ) ) {
+            if ( this->required )
+              throw std::runtime_error( "missing parameter \""+std::string( this->key )+"\" ("
+                +SchemaValue<T>::name()+"): "+this->description );
+            value = def;
+          }
+          if ( !inRange( value, this->min, this->max ) ) {
+            std::ostringstream os;
+            os << "parameter \"" << this->key << "\" out of range [" << this->min << ", " << this->max << "]: ";
+            SchemaValue<T>::print( os, value );
+            throw std::runtime_error( os.str() );
+          }
+        }
+        void dump( std::ostream& os, const S& settings ) const override {
+          os << "\n" << this->key << ": " << SchemaValue<T>::name() << "(";
+          SchemaValue<T>::print( os, settings.*member );
+          os << ")";
+        }
+        T S::* member;
+        T def;
+      };
+      std::vector<std::shared_ptr<FieldBase> > fields_; ///< shared between copies of the schema
+  };
+}
+
+#endif
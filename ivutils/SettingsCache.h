@@ -0,0 +1,49 @@
+#ifndef ivutils_SettingsCache_h
+#define ivutils_SettingsCache_h
+
+#include "ivutils/StringView.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace ivutils
+{
+  /// Shadow model of the settings written to a module
+  /// \note Settings are indexed by their normalised (short form, upper case)
+  ///  SCPI header, without optional nodes, e.g. ":SOURce:VOLTage:LEVel" and
+  ///  "sour:volt" are equivalent; settings with nodes unknown to the model
+  ///  are never cached
+  class SettingsCache
+  {
+    public:
+      SettingsCache() {}
+
+      /// Normalise a SCPI command header into its short form
+      /// \return Empty string if one of the nodes is unknown
+      static std::string header( const StringView& command );
+
+      /// Update the model from a transmitted message
+      /// \note Several commands may be joined by ';'; queries are ignored,
+      ///  and instrument reset commands invalidate the full model
+      void update( const StringView& message );
+      /// Check if a setting is known to hold a given value
+      bool matches( const std::string& header, const std::string& value ) const;
+      /// Retrieve the known value of a setting
+      /// \return False if the setting was never written since the last reset
+      bool get( const std::string& header, std::string& value ) const;
+      /// Set the known value of a setting
+      void set( const std::string& header, const std::string& value ) {
+        if ( !header.empty() )
+          values_[header] = value;
+      }
+      /// Forget a setting, to be read back from the module
+      void erase( const std::string& header ) { values_.erase( header ); }
+      /// Forget all settings
+      void clear() { values_.clear(); }
+
+    private:
+      std::unordered_map<std::string,std::string> values_;
+  };
+}
+
+#endif
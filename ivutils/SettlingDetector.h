@@ -0,0 +1,55 @@
+#ifndef ivutils_SettlingDetector_h
+#define ivutils_SettlingDetector_h
+
+#include <deque>
+#include <string>
+#include <utility>
+
+namespace ivutils
+{
+  /// Detector of the settling of a current after a voltage step
+  /// \note The current is sampled during the relaxation, and considered
+  ///  settled once its expected residual drift is below a relative tolerance
+  class SettlingDetector
+  {
+    public:
+      /// Relaxation model
+      enum Model {
+        slope, ///< drift over the sampling window, from a linear fit
+        exponential ///< distance to the asymptote of an exponential (RC) relaxation
+      };
+
+      /// Build a settling detector
+      /// \param[in] model Relaxation model
+      /// \param[in] tolerance Maximal relative residual drift of the current
+      /// \param[in] window Number of most recent samples considered
+      SettlingDetector( const Model& model, double tolerance, size_t window );
+
+      /// Parse a relaxation model name ("slope" or "exponential")
+      static Model model( const std::string& name );
+
+      /// Forget all samples, e.g. after a new voltage step
+      void reset() { samples_.clear(); estimate_ = 0.; }
+      /// Add a new sample to the window
+      /// \param[in] time Sampling time (in s)
+      /// \param[in] value Sampled current
+      /// \return True if the current is settled
+      bool add( double time, double value );
+      /// Last estimate of the settled current
+      double estimate() const { return estimate_; }
+
+    private:
+      /// Slope-below-threshold criterion
+      bool slopeSettled();
+      /// Exponential extrapolation criterion
+      bool exponentialSettled();
+
+      Model model_;
+      double tolerance_;
+      size_t window_;
+      std::deque<std::pair<double,double> > samples_; ///< (time, value) pairs in the window
+      double estimate_;
+  };
+}
+
+#endif
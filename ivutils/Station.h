@@ -0,0 +1,98 @@
+#ifndef ivutils_Station_h
+#define ivutils_Station_h
+
+#include "ivutils/Device.h"
+#include "ivutils/SettlingDetector.h"
+#include "ivutils/AdaptiveRamp.h"
+#include "ivutils/Statistics.h"
+#include "ivutils/OutputSink.h"
+#include "ivutils/ParametersList.h"
+
+#include <memory>
+
+namespace ivutils
+{
+  /// Measurement station, made of a voltage source and an ammeter
+  class Station
+  {
+    public:
+      /// Validated station parameters
+      struct Settings
+      {
+        ParametersList vsource, ammeter;
+        bool ramp_down, buffered_readout;
+        std::vector<double> ramping_stages;
+        ParametersList adaptive_ramp;
+        int num_repetitions, stable_time, time_at_test;
+        double voltage_at_test;
+        double settle_tolerance;
+        int settle_window;
+        std::string settle_model;
+        /// Description of all station parameters
+        static const Schema<Settings>& schema();
+      };
+
+      /// Build a station from its list of parameters
+      /// \param[in] name Station name (empty for a single-station setup)
+      /// \param[in] params Devices ("vsource" and "ammeter" blocks) and scan parameters
+      Station( const std::string& name, const ParametersList& params );
+      /// Build a station from its validated parameters
+      Station( const std::string& name, const Settings& settings );
+
+      /// Station name
+      const std::string& name() const { return name_; }
+      void configure() const;
+      /// Perform a quick acquisition of a series of currents
+      /// \param[in] output Output for all readings (if any)
+      /// \param[in] index Station index in the output
+      void test( OutputSink* output = nullptr, unsigned short index = 0 ) const;
+
+      void rampDown() const;
+      /// Perform a full I-V scan
+      /// \param[in] output Streaming output for all readings (if any)
+      /// \param[in] index Station index in the output
+      void scan( OutputSink* output = nullptr, unsigned short index = 0 ) const;
+
+    private:
+      /// Check the identity of both modules
+      void checkModules() const;
+      /// Wait for the current to settle after a voltage step
+      /// \note The fixed stabilisation time is used as an upper bound
+      void settle() const;
+      /// Retrieve the voltage of a scan stage
+      /// \return False if the scan is finished
+      bool nextStage( size_t i, double& voltage ) const;
+      /// Maximal number of scan stages
+      size_t numStages() const { return adaptive_ramp_ ? adaptive_ramp_->maxPoints() : ramping_stages_.size(); }
+      /// Accumulate the currents of a list of readings, and stream them to the output
+      RunningStatistics addReadings( size_t i, double voltage, const std::vector<Reading>& readings ) const;
+      /// Compute the current at a voltage stage, and stream it to the output
+      void recordStage( size_t i, double voltage, const RunningStatistics& currents ) const;
+      /// Monitor the current at the test voltage
+      /// \param[out] i_ramp Statistics of the first currents measured, as for any other voltage stage
+      void stabilityTest( size_t i, double voltage, RunningStatistics& i_ramp ) const;
+
+      std::string name_;
+      std::string log_prefix_; ///< prefix of all log messages for this station
+      mutable OutputSink* output_; ///< streaming output of the current scan (if any)
+      mutable unsigned short index_; ///< station index in the output
+      /// SourceMeter communication module
+      Device srcmeter_;
+      /// Ammeter communication module
+      Device ammeter_;
+
+      bool ramp_down_;
+      bool buffered_readout_; ///< use the ammeter buffer to acquire all readings at a voltage stage
+      std::vector<double> ramping_stages_;
+      /// Adaptive voltage stages generator (replaces the fixed list of stages if set)
+      mutable std::unique_ptr<AdaptiveRamp> adaptive_ramp_;
+      size_t num_repetitions_; ///< current values per voltage
+      unsigned int stable_time_; ///< time for stabilizing after changing voltage (in seconds)
+      /// Current settling detector (if not set, the full stabilisation time is waited for)
+      mutable std::unique_ptr<SettlingDetector> settling_;
+      unsigned int time_at_test_; ///< timein stability test at voltage V_test (in seconds)
+      double voltage_at_test_; ///< Voltage to test stability (abs value)
+  };
+}
+
+#endif
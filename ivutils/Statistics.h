@@ -0,0 +1,133 @@
+#ifndef ivutils_Statistics_h
+#define ivutils_Statistics_h
+
+#include <cstddef>
+#include <cmath>
+#include <limits>
+
+namespace ivutils
+{
+  /// Single-pass accumulator of the mean, variance, and extrema of a series
+  /// \note Welford's online algorithm; batches are merged using the Chan et al. formula
+  class RunningStatistics
+  {
+    public:
+      RunningStatistics() { clear(); }
+
+      /// Forget all values
+      void clear() {
+        count_ = 0;
+        mean_ = m2_ = 0.;
+        min_ = std::numeric_limits<double>::infinity();
+        max_ = -std::numeric_limits<double>::infinity();
+      }
+      /// Add a single value
+      void add( double value ) {
+        ++count_;
+        const double delta = value-mean_;
+        mean_ += delta/count_;
+        m2_ += delta*( value-mean_ );
+        if ( value < min_ )
+          min_ = value;
+        if ( value > max_ )
+          max_ = value;
+      }
+      /// Add a batch of values (e.g. a buffered acquisition)
+      void add( const double* values, size_t num_values );
+      /// Merge the values of another accumulator
+      void merge( const RunningStatistics& oth );
+
+      /// Number of values accumulated
+      size_t count() const { return count_; }
+      double mean() const { return mean_; }
+      /// Population variance
+      double variance() const { return count_ > 0 ? m2_/count_ : 0.; }
+      /// Population standard deviation
+      double stdev() const { return std::sqrt( variance() ); }
+      /// Unbiased (sample) variance
+      double sampleVariance() const { return count_ > 1 ? m2_/( count_-1 ) : 0.; }
+      double min() const { return min_; }
+      double max() const { return max_; }
+
+    private:
+      size_t count_;
+      double mean_;
+      double m2_; ///< sum of squared differences to the mean
+      double min_, max_;
+  };
+
+  /// Streaming estimator of a quantile, without storing the values
+  /// \note P-square algorithm (Jain & Chlamtac, 1985), with five markers
+  class P2Quantile
+  {
+    public:
+      /// \param[in] quantile Probability of the quantile to estimate (0.5 for the median)
+      explicit P2Quantile( double quantile = 0.5 );
+
+      /// Forget all values
+      void clear();
+      /// Add a single value
+      void add( double value );
+      /// Number of values accumulated
+      size_t count() const { return count_; }
+      /// Current estimate of the quantile
+      double value() const;
+
+    private:
+      /// Piecewise-parabolic prediction of a marker height
+      double parabolic( int i, int d ) const;
+      /// Linear prediction of a marker height
+      double linear( int i, int d ) const;
+
+      double quantile_;
+      size_t count_;
+      double heights_[5]; ///< marker heights
+      double positions_[5]; ///< actual marker positions
+      double desired_[5]; ///< desired marker positions
+      double increments_[5]; ///< desired positions increments
+  };
+
+  /// Streaming estimator of the median and median absolute deviation (MAD)
+  /// \note The MAD is estimated with respect to the running median estimate
+  class RunningMedian
+  {
+    public:
+      RunningMedian() : median_( 0.5 ), deviation_( 0.5 ) {}
+
+      void clear() { median_.clear(); deviation_.clear(); }
+      void add( double value ) {
+        median_.add( value );
+        deviation_.add( std::fabs( value-median_.value() ) );
+      }
+      size_t count() const { return median_.count(); }
+      double median() const { return median_.value(); }
+      /// Median absolute deviation
+      double mad() const { return deviation_.value(); }
+
+    private:
+      P2Quantile median_;
+      P2Quantile deviation_;
+  };
+
+  /// Exponentially-weighted moving average
+  class EWMA
+  {
+    public:
+      /// \param[in] alpha Weight of the newest value, between 0 and 1
+      explicit EWMA( double alpha ) : alpha_( alpha ), value_( 0. ), empty_( true ) {}
+
+      void clear() { value_ = 0.; empty_ = true; }
+      void add( double value ) {
+        value_ = empty_ ? value : value_+alpha_*( value-value_ );
+        empty_ = false;
+      }
+      double value() const { return value_; }
+
+    private:
+      double alpha_;
+      double value_;
+      bool empty_;
+  };
+}
+
+#endif
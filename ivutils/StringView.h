@@ -0,0 +1,59 @@
+#ifndef ivutils_StringView_h
+#define ivutils_StringView_h
+
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+namespace ivutils
+{
+  /// Non-owning view on a contiguous sequence of characters
+  /// \note The viewed buffer must outlive the view
+  class StringView
+  {
+    public:
+      StringView() : data_( nullptr ), size_( 0 ) {}
+      StringView( const char* data, size_t size ) : data_( data ), size_( size ) {}
+      StringView( const char* str ) : data_( str ), size_( str ? strlen( str ) : 0 ) {}
+      StringView( const std::string& str ) : data_( str.data() ), size_( str.size() ) {}
+
+      const char* data() const { return data_; }
+      size_t size() const { return size_; }
+      bool empty() const { return size_ == 0; }
+      const char* begin() const { return data_; }
+      const char* end() const { return data_+size_; }
+      char operator[]( size_t i ) const { return data_[i]; }
+
+      /// Find the first occurence of a character, starting from a given position
+      size_t find( char c, size_t pos = 0 ) const {
+        if ( pos >= size_ )
+          return std::string::npos;
+        const void* ptr = memchr( data_+pos, c, size_-pos );
+        return ptr ? static_cast<const char*>( ptr )-data_ : std::string::npos;
+      }
+      /// Sub-view of this view
+      StringView substr( size_t pos, size_t len = std::string::npos ) const {
+        if ( pos > size_ )
+          pos = size_;
+        return StringView( data_+pos, std::min( len, size_-pos ) );
+      }
+      /// Copy the viewed characters into a string
+      std::string str() const { return std::string( data_, size_ ); }
+
+      int compare( const StringView& oth ) const {
+        const int res = memcmp( data_, oth.data_, std::min( size_, oth.size_ ) );
+        return res != 0 ? res : ( size_ < oth.size_ ? -1 : size_ > oth.size_ ? 1 : 0 );
+      }
+      friend bool operator==( const StringView& lhs, const StringView& rhs ) { return lhs.size_ == rhs.size_ && lhs.compare( rhs ) == 0; }
+      friend bool operator!=( const StringView& lhs, const StringView& rhs ) { return !( lhs == rhs ); }
+      friend bool operator<( const StringView& lhs, const StringView& rhs ) { return lhs.compare( rhs ) < 0; }
+      friend std::ostream& operator<<( std::ostream& os, const StringView& sv ) { return os.write( sv.data_, sv.size_ ); }
+
+    private:
+      const char* data_;
+      size_t size_;
+  };
+}
+
+#endif
@@ -1,8 +1,14 @@
 #ifndef ivutils_Utils_h
 #define ivutils_Utils_h
 
+#include "ivutils/StringView.h"
+
 #include <cmath>
 #include <numeric>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstdint>
 
 namespace ivutils
 {
@@ -18,20 +24,36 @@ namespace ivutils
     return tokens;
   }
 
+  /// 64-bit FNV-1a hash of a string
+  /// \param[in] seed Hash of the preceding data, for incremental hashing
+  inline uint64_t
+  fnv1a( const StringView& str, uint64_t seed = 0xcbf29ce484222325ull )
+  {
+    uint64_t hash = seed;
+    for ( const auto& c : str ) {
+      hash ^= (unsigned char)c;
+      hash *= 0x100000001b3ull;
+    }
+    return hash;
+  }
+
+  /// Mean of a series of values
+  /// \note See RunningStatistics for a streaming version
   template<typename T> inline T
   mean( const std::vector<T>& vec )
   {
-    return std::accumulate( vec.begin(), vec.end(), 0. )/vec.size();
+    return std::accumulate( vec.begin(), vec.end(), T( 0 ) )/vec.size();
   }
 
+  /// Population standard deviation of a series of values
+  /// \note See RunningStatistics for a streaming version
   template<typename T> inline T
   stdev( const std::vector<T>& vec, T mean )
   {
-    //const double sq_sum = std::inner_product( vec.begin(), vec.end(), vec.begin(), 0. )/vec.size();
-    //const double stdev_i = std::sqrt( sq_sum-mean*mean );
-    std::vector<double> diff( vec.size() );
-    std::transform( vec.begin(), vec.end(), diff.begin(), [mean]( double x ) { return x-mean; } );
-    return std::sqrt( std::inner_product( diff.begin(), diff.end(), diff.begin(), 0. )/vec.size() );
+    T sq_sum = 0;
+    for ( const auto& x : vec )
+      sq_sum += ( x-mean )*( x-mean );
+    return std::sqrt( sq_sum/vec.size() );
   }
 }
 
@@ -0,0 +1,151 @@
+#include "ivutils/AdaptiveRamp.h"
+#include "ivutils/Logger.h"
+
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+using namespace ivutils;
+
+const double AdaptiveRamp::CURRENT_FLOOR = 1.e-15;
+
+const Schema<AdaptiveRamp::Settings>&
+AdaptiveRamp::Settings::schema()
+{
+  static const Schema<Settings> schema = Schema<Settings>()
+    .optional( "start", &Settings::start, 0., "first voltage of the ramp (in V)" )
+    .required( "stop", &Settings::stop, "last voltage of the ramp (in V)" )
+    .required( "maxPoints", &Settings::max_points, "total number of voltage stages" ).range( 2 )
+    .required( "maxStep", &Settings::max_step, "largest allowed voltage step (in V)" ).range( 0 )
+    .optional( "minStep", &Settings::min_step, 0., "smallest allowed voltage step (in V; 0 for maxStep/16)" ).range( 0 )
+    .optional( "riseThreshold", &Settings::rise_threshold, 0.5, "maximal relative current increase over a maximal step" ).range( 0 )
+    .optional( "curvatureThreshold", &Settings::curvature_threshold, 0.5, "maximal change of the logarithmic slope over a maximal step" ).range( 0 )
+    .optional( "compliance", &Settings::compliance, 0., "current at which the ramp is stopped (in A; 0 to disable)" ).range( 0 );
+  return schema;
+}
+
+AdaptiveRamp::AdaptiveRamp( const ParametersList& params, const std::vector<double>& anchors ) :
+  AdaptiveRamp( Settings::schema().bind( params ), anchors )
+{}
+
+AdaptiveRamp::AdaptiveRamp( const Settings& settings, const std::vector<double>& anchors ) :
+  start_( settings.start ), stop_( settings.stop ),
+  max_points_( settings.max_points > 0 ? settings.max_points : 0 ),
+  max_step_( settings.max_step ),
+  min_step_( settings.min_step > 0. ? settings.min_step : max_step_/16. ),
+  rise_threshold_( settings.rise_threshold ),
+  curvature_threshold_( settings.curvature_threshold ),
+  compliance_( settings.compliance ),
+  step_( max_step_ ), finished_( false )
+{
+  if ( max_step_ <= 0. || min_step_ <= 0. || min_step_ > max_step_ )
+    throw std::runtime_error( "Invalid adaptive ramp steps: maximal step must be larger than the (positive) minimal one!" );
+  if ( settings.max_points < 2 )
+    throw std::runtime_error( "Adaptive ramp requires at least two points!" );
+  for ( const auto& v : anchors ) // only keep the anchors within the ramp range
+    if ( ( v-start_ )*( v-stop_ ) < 0. )
+      anchors_.emplace_back( v );
+  if ( 1+pointsNeeded( start_ ) > max_points_ ) {
+    std::ostringstream os;
+    os << "Adaptive ramp cannot reach " << stop_ << " V from " << start_ << " V in " << max_points_
+       << " points with steps of at most " << max_step_ << " V";
+    if ( !anchors_.empty() )
+      os << " and " << anchors_.size() << " anchor(s)";
+    os << "!";
+    throw std::runtime_error( os.str() );
+  }
+}
+
+void
+AdaptiveRamp::reset()
+{
+  step_ = max_step_;
+  finished_ = false;
+  voltages_.clear();
+  log_currents_.clear();
+}
+
+size_t
+AdaptiveRamp::pointsNeeded( double from ) const
+{
+  const double sign = ( stop_ > start_ ) ? 1. : -1.;
+  std::vector<double> bounds( 1, stop_ );
+  for ( const auto& v : anchors_ )
+    if ( sign*( v-from ) > 0. )
+      bounds.emplace_back( v );
+  std::sort( bounds.begin(), bounds.end(), [&sign]( double a, double b ) { return sign*a < sign*b; } );
+  size_t num_points = 0;
+  double last = from;
+  for ( const auto& v : bounds ) {
+    const double segment = sign*( v-last );
+    if ( segment > 0. ) // tolerate rounding errors on exact multiples of the step
+      num_points += (size_t)std::ceil( segment/max_step_*( 1.-1.e-9 ) );
+    last = v;
+  }
+  return num_points;
+}
+
+bool
+AdaptiveRamp::next( double& voltage )
+{
+  if ( finished_ )
+    return false;
+  if ( voltages_.empty() ) {
+    voltage = start_;
+    return true;
+  }
+  const double last = voltages_.back(), sign = ( stop_ > start_ ) ? 1. : -1.;
+  if ( sign*( stop_-last ) <= 0. )
+    return false;
+  if ( voltages_.size() >= max_points_ ) {
+    IVUTILS_LOG( warning ) << "Adaptive ramp points budget exhausted at " << last << " V, before reaching " << stop_ << " V.";
+    return false;
+  }
+  //--- never step over an anchor
+  double bound = stop_;
+  for ( const auto& v : anchors_ )
+    if ( sign*( v-last ) > 0. && sign*( v-bound ) < 0. )
+      bound = v;
+  //--- keep enough points in the budget to reach the end of the range (and
+  //    all anchors on the way), but never exceed the largest step
+  const size_t points_left = max_points_-voltages_.size(), points_after = pointsNeeded( bound );
+  const double segment = sign*( bound-last );
+  const double step = std::min( std::max( step_, segment/std::max<size_t>( points_left-std::min( points_left, points_after ), 1 ) ), max_step_ );
+  voltage = last+sign*std::min( step, segment );
+  return true;
+}
+
+void
+AdaptiveRamp::add( double voltage, double current )
+{
+  voltages_.emplace_back( voltage );
+  log_currents_.emplace_back( std::log( std::fabs( current )+CURRENT_FLOOR ) );
+  if ( compliance_ > 0. && std::fabs( current ) >= compliance_ ) {
+    IVUTILS_LOG( warning ) << "Current limit of " << compliance_ << " A reached at " << voltage << " V; stopping the ramp.";
+    finished_ = true;
+    return;
+  }
+  const size_t n = voltages_.size();
+  if ( n < 2 )
+    return;
+  //--- relative current increase, normalised to the largest step
+  const double dv = std::fabs( voltages_[n-1]-voltages_[n-2] );
+  if ( dv <= 0. )
+    return;
+  const double slope = ( log_currents_[n-1]-log_currents_[n-2] )/dv; // along the ramp direction
+  const double rise = slope*max_step_; // a decreasing current (e.g. a capacitive decay) is not refined
+  //--- change of the logarithmic slope between the last two intervals
+  double curvature = 0.;
+  if ( n >= 3 ) {
+    const double dv_prev = std::fabs( voltages_[n-2]-voltages_[n-3] );
+    if ( dv_prev > 0. ) {
+      const double slope_prev = ( log_currents_[n-2]-log_currents_[n-3] )/dv_prev;
+      curvature = std::fabs( slope-slope_prev )/( 0.5*( dv+dv_prev ) )*max_step_*max_step_;
+    }
+  }
+  if ( rise > rise_threshold_ || curvature > curvature_threshold_ )
+    step_ = std::max( 0.5*step_, min_step_ );
+  else if ( rise < 0.25*rise_threshold_ && curvature < 0.25*curvature_threshold_ )
+    step_ = std::min( 2.*step_, max_step_ );
+}
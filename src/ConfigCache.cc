@@ -0,0 +1,281 @@
+#include "ivutils/ConfigCache.h"
+#include "ivutils/Logger.h"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdio>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace ivutils;
+
+const char ConfigCache::MAGIC[4] = { 'I', 'V', 'C', 'C' };
+const uint32_t ConfigCache::VERSION = 1;
+
+namespace
+{
+  //--- fixed-size fields are stored in the host byte order, as the cache never leaves the machine
+
+  template<typename T> void
+  write( std::string& out, const T& value )
+  {
+    out.append( reinterpret_cast<const char*>( &value ), sizeof( T ) );
+  }
+
+  void
+  writeString( std::string& out, const StringView& str )
+  {
+    write<uint32_t>( out, str.size() );
+    out.append( str.data(), str.size() );
+  }
+
+  template<typename T> T
+  read( StringView& data )
+  {
+    if ( data.size() < sizeof( T ) )
+      throw std::runtime_error( "Truncated configuration cache!" );
+    T value;
+    memcpy( &value, data.data(), sizeof( T ) ); // no alignment guarantee in the mapping
+    data = data.substr( sizeof( T ) );
+    return value;
+  }
+
+  /// Read a number of elements, checked against the remaining data size
+  uint32_t
+  readCount( StringView& data, size_t min_element_size )
+  {
+    const uint32_t count = read<uint32_t>( data );
+    if ( data.size() < count*min_element_size )
+      throw std::runtime_error( "Truncated configuration cache!" );
+    return count;
+  }
+
+  StringView
+  readString( StringView& data )
+  {
+    const uint32_t size = read<uint32_t>( data );
+    if ( data.size() < size )
+      throw std::runtime_error( "Truncated configuration cache!" );
+    const StringView out = data.substr( 0, size );
+    data = data.substr( size );
+    return out;
+  }
+
+  /// Read-only memory mapping of a whole file
+  class FileMapping
+  {
+    public:
+      explicit FileMapping( const std::string& path ) : data_( nullptr ), size_( 0 ) {
+        const int fd = open( path.c_str(), O_RDONLY );
+        if ( fd < 0 )
+          return;
+        struct stat st;
+        if ( fstat( fd, &st ) == 0 && st.st_size > 0 ) {
+          void* ptr = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+          if ( ptr != MAP_FAILED ) {
+            data_ = ptr;
+            size_ = st.st_size;
+          }
+        }
+        close( fd ); // the mapping stays valid
+      }
+      ~FileMapping() {
+        if ( data_ )
+          munmap( data_, size_ );
+      }
+      StringView view() const { return StringView( static_cast<const char*>( data_ ), size_ ); }
+
+    private:
+      void* data_;
+      size_t size_;
+  };
+}
+
+ConfigCache::ConfigCache( const std::string& card )
+{
+  std::ostringstream os;
+  os << ".ivutils_config_" << std::hex << std::setw( 16 ) << std::setfill( '0' ) << fnv1a( card );
+  path_ = os.str();
+}
+
+bool
+ConfigCache::fileHash( const std::string& path, uint64_t& hash )
+{
+  FileMapping file( path );
+  if ( file.view().data() == nullptr ) {
+    std::ifstream empty( path ); // an empty file cannot be mapped
+    if ( !empty )
+      return false;
+  }
+  hash = fnv1a( file.view() );
+  return true;
+}
+
+bool
+ConfigCache::load( ParametersList& params ) const
+{
+  FileMapping file( path_ );
+  StringView data = file.view();
+  if ( data.size() < sizeof( MAGIC ) || memcmp( data.data(), MAGIC, sizeof( MAGIC ) ) != 0 )
+    return false;
+  data = data.substr( sizeof( MAGIC ) );
+  try {
+    if ( read<uint32_t>( data ) != VERSION )
+      return false;
+    //--- check that no dependency changed since the cache was built
+    const uint32_t num_deps = read<uint32_t>( data );
+    for ( uint32_t i = 0; i < num_deps; ++i ) {
+      const std::string dep = readString( data ).str();
+      const uint64_t stored_hash = read<uint64_t>( data );
+      uint64_t hash = 0;
+      if ( !fileHash( dep, hash ) || hash != stored_hash ) {
+        IVUTILS_LOG( info ) << "Configuration changed since the last parsing (" << dep << "); rebuilding the cache.";
+        return false;
+      }
+    }
+    params = deserialise( data );
+  } catch ( const std::runtime_error& err ) {
+    IVUTILS_LOG( warning ) << "Invalid configuration cache \"" << path_ << "\": " << err.what();
+    return false;
+  }
+  IVUTILS_LOG( debug ) << "Configuration loaded from cache \"" << path_ << "\".";
+  return true;
+}
+
+void
+ConfigCache::save( const ParametersList& params, const std::vector<std::string>& dependencies ) const
+{
+  std::string out( MAGIC, sizeof( MAGIC ) );
+  write<uint32_t>( out, VERSION );
+  write<uint32_t>( out, dependencies.size() );
+  for ( const auto& dep : dependencies ) {
+    uint64_t hash = 0;
+    if ( !fileHash( dep, hash ) ) {
+      IVUTILS_LOG( warning ) << "Failed to read configuration dependency \"" << dep << "\"; configuration will not be cached.";
+      return;
+    }
+    writeString( out, dep );
+    write<uint64_t>( out, hash );
+  }
+  serialise( params, out );
+  //--- write into a temporary file, and atomically replace the previous cache
+  const std::string tmp_path = path_+".tmp";
+  {
+    std::ofstream file( tmp_path, std::ios::binary );
+    if ( !( file.write( out.data(), out.size() ) ) ) {
+      IVUTILS_LOG( warning ) << "Failed to write the configuration cache into \"" << tmp_path << "\".";
+      return;
+    }
+  }
+  if ( rename( tmp_path.c_str(), path_.c_str() ) != 0 )
+    IVUTILS_LOG( warning ) << "Failed to store the configuration cache into \"" << path_ << "\".";
+}
+
+void
+ConfigCache::serialise( const ParametersList& params, std::string& out )
+{
+  const auto& keys = params.keys();
+  write<uint32_t>( out, keys.size() );
+  for ( const auto& key : keys ) {
+    const ParametersList::Type type = params.type( key );
+    writeString( out, key );
+    write<uint8_t>( out, type );
+    switch ( type ) {
+      case ParametersList::integer:
+        write<int32_t>( out, params.getParameter<int>( key ) );
+        break;
+      case ParametersList::real:
+        write<double>( out, params.getParameter<double>( key ) );
+        break;
+      case ParametersList::string:
+        writeString( out, params.getParameter<std::string>( key ) );
+        break;
+      case ParametersList::params:
+        serialise( params.getParameter<ParametersList>( key ), out );
+        break;
+      case ParametersList::vec_integer: {
+        const auto& vec = params.getParameter<std::vector<int> >( key );
+        write<uint32_t>( out, vec.size() );
+        for ( const auto& v : vec )
+          write<int32_t>( out, v );
+      } break;
+      case ParametersList::vec_real: {
+        const auto& vec = params.getParameter<std::vector<double> >( key );
+        write<uint32_t>( out, vec.size() );
+        for ( const auto& v : vec )
+          write<double>( out, v );
+      } break;
+      case ParametersList::vec_string: {
+        const auto& vec = params.getParameter<std::vector<std::string> >( key );
+        write<uint32_t>( out, vec.size() );
+        for ( const auto& v : vec )
+          writeString( out, v );
+      } break;
+      case ParametersList::vec_params: {
+        const auto& vec = params.getParameter<std::vector<ParametersList> >( key );
+        write<uint32_t>( out, vec.size() );
+        for ( const auto& v : vec )
+          serialise( v, out );
+      } break;
+      case ParametersList::invalid: default:
+        throw std::runtime_error( "Invalid type for parameter with key="+key+"!" );
+    }
+  }
+}
+
+ParametersList
+ConfigCache::deserialise( StringView& data )
+{
+  ParametersList out;
+  const uint32_t num_keys = read<uint32_t>( data );
+  for ( uint32_t i = 0; i < num_keys; ++i ) {
+    const StringView key = readString( data );
+    const uint8_t type = read<uint8_t>( data );
+    switch ( type ) {
+      case ParametersList::integer:
+        out.set<int>( key, read<int32_t>( data ) );
+        break;
+      case ParametersList::real:
+        out.set<double>( key, read<double>( data ) );
+        break;
+      case ParametersList::string:
+        out.set<std::string>( key, readString( data ).str() );
+        break;
+      case ParametersList::params:
+        out.set<ParametersList>( key, deserialise( data ) );
+        break;
+      case ParametersList::vec_integer: {
+        std::vector<int> vec( readCount( data, sizeof( int32_t ) ) );
+        for ( auto& v : vec )
+          v = read<int32_t>( data );
+        out.set<std::vector<int> >( key, vec );
+      } break;
+      case ParametersList::vec_real: {
+        std::vector<double> vec( readCount( data, sizeof( double ) ) );
+        for ( auto& v : vec )
+          v = read<double>( data );
+        out.set<std::vector<double> >( key, vec );
+      } break;
+      case ParametersList::vec_string: {
+        std::vector<std::string> vec( readCount( data, sizeof( uint32_t ) ) );
+        for ( auto& v : vec )
+          v = readString( data ).str();
+        out.set<std::vector<std::string> >( key, vec );
+      } break;
+      case ParametersList::vec_params: {
+        std::vector<ParametersList> vec( readCount( data, sizeof( uint32_t ) ) );
+        for ( auto& v : vec )
+          v = deserialise( data );
+        out.set<std::vector<ParametersList> >( key, vec );
+      } break;
+      default:
+        throw std::runtime_error( "Invalid type "+std::to_string( type )+" for parameter with key="+key.str()+"!" );
+    }
+  }
+  return out;
+}
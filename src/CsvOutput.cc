@@ -0,0 +1,69 @@
+#include "ivutils/CsvOutput.h"
+
+#include <stdexcept>
+#include <limits>
+
+using namespace ivutils;
+
+const std::chrono::seconds CsvOutput::DEFAULT_FLUSH_INTERVAL( 10 );
+
+CsvOutput::CsvOutput( const std::string& prefix, const std::chrono::seconds& flush_interval ) :
+  readings_( prefix+"_readings.csv" ), stages_( prefix+"_stages.csv" ), stability_( prefix+"_stability.csv" ),
+  flush_interval_( flush_interval ), last_flush_( std::chrono::steady_clock::now() ),
+  start_( std::chrono::system_clock::now() )
+{
+  if ( !readings_ || !stages_ || !stability_ )
+    throw std::runtime_error( "Failed to open the output files with prefix \""+prefix+"\"!" );
+  for ( auto* file : { &readings_, &stages_, &stability_ } )
+    file->precision( std::numeric_limits<double>::max_digits10 );
+  readings_ << "station,stage,voltage,time,timestamp,current,status\n";
+  stages_ << "station,stage,voltage,time,current,stdev,numReadings\n";
+  stability_ << "station,time,current\n";
+  autoFlush( true );
+}
+
+double
+CsvOutput::elapsed() const
+{
+  return std::chrono::duration<double>( std::chrono::system_clock::now()-start_ ).count();
+}
+
+void
+CsvOutput::addReading( unsigned short station, unsigned short stage, double voltage, const Reading& reading )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  readings_
+    << station << "," << stage << "," << voltage << "," << elapsed() << ","
+    << reading.timestamp << "," << reading.value << "," << reading.status << "\n";
+  autoFlush();
+}
+
+void
+CsvOutput::addStage( unsigned short station, unsigned short stage, double voltage, double mean, double stdev, unsigned int num_readings )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  stages_
+    << station << "," << stage << "," << voltage << "," << elapsed() << ","
+    << mean << "," << stdev << "," << num_readings << "\n";
+  autoFlush( true ); // a stage summary is always made persistent
+}
+
+void
+CsvOutput::addStabilityPoint( unsigned short station, double time, double current )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  stability_ << station << "," << time << "," << current << "\n";
+  autoFlush();
+}
+
+void
+CsvOutput::autoFlush( bool force )
+{
+  const auto now = std::chrono::steady_clock::now();
+  if ( !force && now-last_flush_ < flush_interval_ )
+    return;
+  readings_.flush();
+  stages_.flush();
+  stability_.flush();
+  last_flush_ = now;
+}
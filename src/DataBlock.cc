@@ -0,0 +1,93 @@
+#include "ivutils/DataBlock.h"
+
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+  /// Reverse the byte order of a 32-bit word (recognised as a single instruction by optimising compilers)
+  inline uint32_t
+  byteSwap( uint32_t word )
+  {
+    return ( word >> 24 )
+      | ( ( word >> 8 ) & 0x0000ff00u )
+      | ( ( word << 8 ) & 0x00ff0000u )
+      | ( word << 24 );
+  }
+
+  /// Reverse the byte order of a 64-bit word
+  inline uint64_t
+  byteSwap( uint64_t word )
+  {
+    return ( static_cast<uint64_t>( byteSwap( static_cast<uint32_t>( word ) ) ) << 32 )
+      | byteSwap( static_cast<uint32_t>( word >> 32 ) );
+  }
+}
+
+namespace ivutils
+{
+  bool
+  hostIsBigEndian()
+  {
+    const uint16_t one = 1;
+    return *reinterpret_cast<const uint8_t*>( &one ) == 0;
+  }
+
+  size_t
+  decodeBlock( const StringView& block, size_t value_size, bool big_endian, double* values, size_t max_values )
+  {
+    if ( value_size != 4 && value_size != 8 )
+      throw std::runtime_error( "Invalid binary value size: "+std::to_string( value_size )+" bytes!" );
+    //--- parse the block header
+    if ( block.size() < 2 || block[0] != '#' || block[1] < '0' || block[1] > '9' )
+      throw std::runtime_error( "Invalid binary block header!" );
+    const size_t num_digits = block[1]-'0';
+    StringView data;
+    if ( num_digits == 0 ) { // indefinite-length block
+      data = block.substr( 2 );
+      if ( data.size() % value_size == 1 && data[data.size()-1] == '\n' )
+        data = data.substr( 0, data.size()-1 );
+    }
+    else {
+      if ( block.size() < 2+num_digits )
+        throw std::runtime_error( "Truncated binary block header!" );
+      size_t length = 0;
+      for ( size_t i = 0; i < num_digits; ++i ) {
+        const char dig = block[2+i];
+        if ( dig < '0' || dig > '9' )
+          throw std::runtime_error( "Invalid binary block length!" );
+        length = length*10+( dig-'0' );
+      }
+      if ( block.size() < 2+num_digits+length )
+        throw std::runtime_error( "Truncated binary block: expecting "+std::to_string( length )+" bytes!" );
+      data = block.substr( 2+num_digits, length );
+    }
+    if ( data.size() % value_size != 0 )
+      throw std::runtime_error( "Binary block length is not a multiple of the value size!" );
+
+    //--- decode all values
+    const bool swap = ( big_endian != hostIsBigEndian() );
+    const size_t num_values = std::min( data.size()/value_size, max_values );
+    const char* ptr = data.data();
+    if ( value_size == 4 )
+      for ( size_t i = 0; i < num_values; ++i, ptr += 4 ) {
+        uint32_t word;
+        memcpy( &word, ptr, 4 );
+        if ( swap )
+          word = byteSwap( word );
+        float value;
+        memcpy( &value, &word, 4 );
+        values[i] = value;
+      }
+    else
+      for ( size_t i = 0; i < num_values; ++i, ptr += 8 ) {
+        uint64_t word;
+        memcpy( &word, ptr, 8 );
+        if ( swap )
+          word = byteSwap( word );
+        memcpy( &values[i], &word, 8 );
+      }
+    return num_values;
+  }
+}
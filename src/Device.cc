@@ -1,31 +1,90 @@
 #include "ivutils/Device.h"
 #include "ivutils/ParametersList.h"
-#include "ivutils/Utils.h"
+#include "ivutils/Schema.h"
+#include "ivutils/DataBlock.h"
 #include "ivutils/Logger.h"
+#include "ivutils/Utils.h"
 
 #include <iostream>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
 
 using namespace ivutils;
 
 const std::string Device::M_DEVICE_ID = "*IDN?";
 const std::string Device::M_RESET = "*RST";
 const std::string Device::M_READ = ":READ?";
+const unsigned int Device::DEFAULT_BUFFER_TIMEOUT_MS = 30000;
+
+const Schema<Device::Settings>&
+Device::Settings::schema()
+{
+  static const Schema<Settings> schema = Schema<Settings>()
+    .required( "address", &Settings::address, "primary GPIB address of the module" ).range( 0, 30 )
+    .optional( "secondaryAddress", &Settings::secondary_address, 0, "secondary GPIB address of the module" ).range( 0, 15 )
+    .optional( "board", &Settings::board, 0, "index of the GPIB interface board the module is connected to" ).range( 0 )
+    .required( "configCommands", &Settings::config_commands, "commands configuring the module" )
+    .required( "operationCommands", &Settings::operation_commands, "commands starting the module operation" )
+    .required( "closingCommands", &Settings::closing_commands, "commands sent when releasing the module" )
+    .optional( "inputBufferSize", &Settings::input_buffer_size, (int)DEFAULT_INPUT_BUFFER_SIZE, "maximal length of a single message sent to the module" ).range( 1 )
+    .optional( "completionMode", &Settings::completion_mode, std::string( "delay" ), "query completion detection ('delay', 'poll', or 'srq')" )
+    .optional( "queryTimeout", &Settings::query_timeout, (int)DEFAULT_TIMEOUT_MS, "deadline for an answer to be available (in ms)" ).range( 1 )
+    .optional( "bufferTimeout", &Settings::buffer_timeout, (int)DEFAULT_BUFFER_TIMEOUT_MS, "deadline for a buffered acquisition to complete (in ms)" ).range( 1 )
+    .optional( "dataFormat", &Settings::data_format, std::string( "ascii" ), "numerical values transfer format ('ascii', 'real32', or 'real64')" )
+    .optional( "dataElements", &Settings::data_elements, std::vector<std::string>(), "elements transmitted for each reading" )
+    .optional( "warmAttach", &Settings::warm_attach, false, "skip the reset and configuration if the module state is unchanged" )
+    .optional( "stateFile", &Settings::state_file, std::string(), "file holding the module fingerprint" )
+    .optional( "stateQuery", &Settings::state_query, std::string(), "query reading back a configured setting (required for a warm attach)" );
+  return schema;
+}
 
 Device::Device( const ParametersList& params ) :
-  Messenger( params.getParameter<int>( "address" ),
-             params.hasParameter<int>( "secondaryAddress" ) ? params.getParameter<int>( "secondaryAddress" ) : 0 ),
-  configCommands_   ( params.getParameter<std::vector<std::string> >( "configCommands" ) ),
-  operationCommands_( params.getParameter<std::vector<std::string> >( "operationCommands" ) ),
-  closingCommands_  ( params.getParameter<std::vector<std::string> >( "closingCommands" ) )
+  Device( Settings::schema().bind( params ) )
+{}
+
+Device::Device( const Settings& settings ) :
+  Messenger( settings.address, settings.secondary_address, settings.board ),
+  configCommands_   ( settings.config_commands ),
+  operationCommands_( settings.operation_commands ),
+  closingCommands_  ( settings.closing_commands ),
+  data_format_( ascii ), big_endian_( hostIsBigEndian() ),
+  buffer_timeout_ms_( settings.buffer_timeout ),
+  state_query_( settings.state_query ),
+  warm_attached_( false )
 {
-  reset();
+  if ( !settings.data_elements.empty() )
+    reading_parser_ = ReadingParser( settings.data_elements );
+  if ( settings.warm_attach ) {
+    //--- the identification string survives a power cycle or a reset,
+    //    only a configured setting can tell them apart
+    if ( state_query_.empty() )
+      throw std::runtime_error( "A state query reading back a configured setting (stateQuery) is required for a warm attach!" );
+    state_file_ = !settings.state_file.empty()
+      ? settings.state_file
+      : ".ivutils_state_"+std::to_string( settings.board )+"_"+std::to_string( settings.address );
+    warm_attached_ = attach();
+  }
+  //--- the device clear sent at the messenger construction only flushes the
+  //    module I/O buffers (e.g. answers left by an interrupted session), and
+  //    is kept even when warm-attaching; the reset drops the full configuration
+  if ( !warm_attached_ )
+    reset();
+  setInputBufferSize( settings.input_buffer_size );
+  setCompletionMode( completionMode( settings.completion_mode ), settings.query_timeout );
+  //--- always transmitted, as a warm-attached module may hold another format
+  setDataFormat( dataFormat( settings.data_format ) );
+  if ( !settings.data_elements.empty() )
+    queue( ":FORM:ELEM "+reading_parser_.elementsList() );
   //const auto& dev_id = fetch( M_DEVICE_ID );
 }
 
 Device::~Device()
 {
   for ( const auto& c : closingCommands_ )
-    send( c );
+    queue( c );
+  flush();
 }
 
 void
@@ -37,33 +96,290 @@ Device::reset() const
 void
 Device::initialise() const
 {
-  for ( const auto& c : configCommands_ )
-    send( c );
+  if ( !warm_attached_ )
+    for ( const auto& c : configCommands_ )
+      queue( c );
   for ( const auto& c : operationCommands_ )
-    send( c );
+    queue( c );
+  flush();
+  if ( warm_attached_ || state_file_.empty() )
+    return;
+  //--- store the fingerprint of the configured module for the next session
+  std::ofstream file( state_file_ );
+  if ( !( file << fingerprint() << "\n" ) )
+    IVUTILS_LOG( warning ) << "Failed to store the device state into \"" << state_file_ << "\".";
+}
+
+const std::string&
+Device::identity() const
+{
+  return execute( [this]() -> const std::string& {
+    if ( identity_.empty() ) {
+      const auto& answer = fetch( M_DEVICE_ID );
+      if ( !answer.empty() )
+        identity_ = answer.at( 0 );
+    }
+    return identity_;
+  } );
+}
+
+bool
+Device::attach() const
+{
+  std::ifstream file( state_file_ );
+  std::string stored;
+  if ( !( file >> stored ) ) {
+    IVUTILS_LOG( info ) << "No previous state found in \"" << state_file_ << "\"; performing a full initialisation.";
+    return false;
+  }
+  if ( stored != fingerprint() ) {
+    IVUTILS_LOG( info ) << "Device configuration or state changed since the last session; performing a full initialisation.";
+    return false;
+  }
+  //--- the module still holds the configuration; feed it to the shadow model,
+  //    except for the source levels and output state, which may have changed
+  //    since (e.g. a session not ramped down); these are read back on demand
+  execute( [this]() {
+    for ( const auto& c : configCommands_ )
+      settings().update( c );
+    for ( const auto& h : { ":SOUR:VOLT:LEV", ":SOUR:CURR:LEV", ":OUTP" } )
+      settings().erase( SettingsCache::header( h ) );
+  } );
+  IVUTILS_LOG( info ) << "Device state unchanged since the last session; skipping its reset and configuration.";
+  return true;
+}
+
+std::string
+Device::fingerprint() const
+{
+  uint64_t hash = fnv1a( "" );
+  for ( const auto& c : configCommands_ )
+    hash = fnv1a( c+"\n", hash );
+  hash = fnv1a( reading_parser_.elementsList()+"\n", hash );
+  //--- identify the module, to detect a different one
+  hash = fnv1a( identity()+"\n", hash );
+  //--- read back a configured setting, to detect a power cycle or a reset
+  for ( const auto& line : fetch( state_query_ ) )
+    hash = fnv1a( line+"\n", hash );
+  std::ostringstream os;
+  os << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash;
+  return os.str();
 }
 
-std::pair<unsigned long, double>
+bool
+Device::triggerSetting( const std::string& header )
+{
+  //--- unknown settings may alter anything
+  if ( header.empty() )
+    return true;
+  for ( const auto& subsystem : { ":ARM", ":TRIG", ":TRAC", ":FORM", ":INIT" } )
+    if ( header.compare( 0, strlen( subsystem ), subsystem ) == 0 )
+      return true;
+  return false;
+}
+
+Device::DataFormat
+Device::dataFormat( const std::string& name )
+{
+  if ( name == "ascii" )
+    return ascii;
+  if ( name == "real32" )
+    return real32;
+  if ( name == "real64" )
+    return real64;
+  throw std::runtime_error( "Invalid data format: \""+name+"\". Valid formats are \"ascii\", \"real32\", and \"real64\"." );
+}
+
+void
+Device::setDataFormat( const DataFormat& format )
+{
+  execute( [&]() {
+    data_format_ = format;
+    switch ( format ) {
+      case ascii: queue( ":FORM:DATA ASC" ); return;
+      case real32: queue( ":FORM:DATA REAL,32" ); break;
+      case real64: queue( ":FORM:DATA REAL,64" ); break;
+    }
+    //--- spare the byte swapping on the host side
+    queue( big_endian_ ? ":FORM:BORD NORM" : ":FORM:BORD SWAP" );
+  } );
+}
+
+bool
+Device::set( const std::string& header, const std::string& value ) const
+{
+  const std::string norm_header = SettingsCache::header( header );
+  return execute( [&]() {
+    if ( settings().matches( norm_header, value ) ) {
+      IVUTILS_LOG( debug ) << "Skipping redundant setting: " << header << " " << value << ".";
+      return false;
+    }
+    send( header+" "+value );
+    return true;
+  }, IOExecutor::setPoint, triggerSetting( norm_header ) );
+}
+
+bool
+Device::set( const std::string& header, double value ) const
+{
+  std::ostringstream os;
+  os << value;
+  return set( header, os.str() );
+}
+
+std::future<bool>
+Device::setAsync( const std::string& header, double value ) const
+{
+  return executeAsync( [this, header, value]() { return set( header, value ); },
+    IOExecutor::setPoint, 0, triggerSetting( SettingsCache::header( header ) ) );
+}
+
+std::string
+Device::setting( const std::string& header ) const
+{
+  return execute( [&]() {
+    std::string value;
+    if ( !settings().get( SettingsCache::header( header ), value ) )
+      value = verify( header ); // never written since the last reset
+    return value;
+  } );
+}
+
+std::string
+Device::verify( const std::string& header ) const
+{
+  return execute( [&]() {
+    const auto& answer = fetch( header+"?" );
+    if ( answer.empty() )
+      throw std::runtime_error( "No answer received for setting "+header+"!" );
+    const std::string norm_header = SettingsCache::header( header );
+    std::string cached;
+    if ( settings().get( norm_header, cached ) && !settings().matches( norm_header, answer.at( 0 ) ) )
+      IVUTILS_LOG( warning ) << "Setting " << header << " differs from its last written value: "
+        << answer.at( 0 ) << " != " << cached << ".";
+    settings().set( norm_header, answer.at( 0 ) );
+    return answer.at( 0 );
+  } );
+}
+
+size_t
+Device::readValues( const std::string& command, double* values, size_t max_values, unsigned int timeout_ms ) const
+{
+  return execute( [&]() {
+    const StringView answer = fetchRaw( command, timeout_ms );
+    if ( data_format_ != ascii )
+      return decodeBlock( answer, data_format_ == real32 ? 4 : 8, big_endian_, values, max_values );
+    return ReadingParser::parseValues( answer, values, max_values );
+  } );
+}
+
+size_t
+Device::readReadings( const std::string& command, std::vector<Reading>& readings, unsigned int timeout_ms ) const
+{
+  return execute( [&]() {
+    const StringView answer = fetchRaw( command, timeout_ms );
+    if ( data_format_ == ascii )
+      return reading_parser_.parse( answer, readings );
+    const size_t value_size = ( data_format_ == real32 ) ? 4 : 8;
+    values_.resize( answer.size()/value_size );
+    const size_t num_values = decodeBlock( answer, value_size, big_endian_, values_.data(), values_.size() );
+    return reading_parser_.fill( values_.data(), num_values, readings );
+  } );
+}
+
+Reading
 Device::readValue( const std::string command, std::string unit ) const
 {
-  const auto& rd = fetch( command );
-  if ( rd.size() != 1 )
-    throw std::runtime_error( "Invalid values read from device!" );
+  return execute( [&]() {
+    if ( readReadings( command, readings_ ) == 0 )
+      throw std::runtime_error( "Invalid values read from device!" );
+    return readings_.front();
+  } );
+}
 
-  const auto values = split( rd.at( 0 ), ',' );
+std::future<Reading>
+Device::readValueAsync( const std::string& command ) const
+{
+  return executeAsync( [this, command]() { return readValue( command ); } );
+}
 
-  double value = 0.;
-  unsigned long timestamp = 0;
-  try {
-    value = std::stod( values.at( 0 ) );
-  } catch ( const std::invalid_argument& ) {
-    throw std::runtime_error( "Failed to parse the answer from device: "+values.at( 0 ) );
-  }
-  if ( values.size() > 1 )
+void
+Device::acquireBuffer( size_t num_readings ) const
+{
+  execute( [&]() {
     try {
-      timestamp = std::stol( values.at( 1 ) );
-    } catch ( const std::invalid_argument& ) {
-      throw std::runtime_error( "Failed to parse the timestamp from device: "+values.at( 1 ) );
+      //--- arm the trigger and trace subsystems for the requested number of readings
+      queue( ":FORM:ELEM "+reading_parser_.elementsList() );
+      queue( ":TRAC:CLE" );
+      queue( ":TRAC:POIN "+std::to_string( num_readings ) );
+      queue( ":TRIG:COUN "+std::to_string( num_readings ) );
+      queue( ":TRAC:FEED SENS" );
+      queue( ":TRAC:FEED:CONT NEXT" );
+      send( ":INIT" );
+      //--- wait for the acquisition to complete
+      const auto& opc = fetch( "*OPC?", buffer_timeout_ms_ );
+      if ( opc.empty() || opc.at( 0 ) != "1" )
+        throw std::runtime_error( "Buffered acquisition failed to complete!" );
+    } catch ( const std::runtime_error& ) {
+      abortBuffer();
+      throw;
     }
-  return std::make_pair( timestamp, value );
+  } );
+}
+
+std::vector<Reading>
+Device::fetchBuffer( size_t num_readings ) const
+{
+  return execute( [&]() {
+    //--- retrieve all readings in one transfer
+    std::vector<Reading> out;
+    out.reserve( num_readings );
+    try {
+      if ( readReadings( ":TRAC:DATA?", out ) != num_readings )
+        throw std::runtime_error( "Invalid number of readings in device buffer: "+std::to_string( out.size() )+"!" );
+    } catch ( const std::runtime_error& ) {
+      abortBuffer();
+      throw;
+    }
+    //--- restore the single-reading trigger model
+    queue( ":TRAC:FEED:CONT NEV" );
+    queue( ":TRIG:COUN 1" );
+    return out;
+  }, IOExecutor::bulk );
+}
+
+void
+Device::abortBuffer() const
+{
+  //--- never leave the module armed for a buffered acquisition,
+  //    the original error is reported by the caller
+  try {
+    send( ":ABOR" );
+    queue( ":TRAC:FEED:CONT NEV" );
+    queue( ":TRIG:COUN 1" );
+    flush();
+  } catch ( const std::runtime_error& err ) {
+    IVUTILS_LOG( warning ) << "Failed to restore the single-reading trigger model: " << err.what();
+  }
+}
+
+std::future<std::vector<Reading> >
+Device::fetchBufferAsync( size_t num_readings ) const
+{
+  return executeAsync( [this, num_readings]() { return fetchBuffer( num_readings ); }, IOExecutor::bulk );
+}
+
+std::vector<Reading>
+Device::readBuffer( size_t num_readings ) const
+{
+  return execute( [&]() {
+    acquireBuffer( num_readings );
+    return fetchBuffer( num_readings );
+  }, IOExecutor::bulk );
+}
+
+std::future<std::vector<Reading> >
+Device::readBufferAsync( size_t num_readings ) const
+{
+  return executeAsync( [this, num_readings]() { return readBuffer( num_readings ); }, IOExecutor::bulk );
 }
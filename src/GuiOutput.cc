@@ -0,0 +1,77 @@
+#include "ivutils/GuiOutput.h"
+
+#include <algorithm>
+
+using namespace ivutils;
+
+GuiOutput::GuiOutput( const std::vector<std::string>& stations ) :
+  plots_( std::max<size_t>( stations.size(), 1 ) ), test_mode_( false )
+{
+  for ( size_t i = 0; i < plots_.size(); ++i ) {
+    auto& plots = plots_.at( i );
+    const std::string graph_prefix = ( i < stations.size() && !stations.at( i ).empty() ) ? stations.at( i )+"_" : "";
+    plots.meas.graph().SetName( ( graph_prefix+"iv_scan" ).c_str() );
+    plots.meas.graph().SetTitle( ";Bias (V);Leakage current (A)" );
+    plots.meas.graph().SetMarkerStyle( 24 );
+    plots.meas.graph().SetLineWidth( 2 );
+    plots.stability.graph().SetName( ( graph_prefix+"stability_vs_time" ).c_str() );
+    plots.stability.graph().SetTitle( ";Time (s);Leakage current (A)" );
+    plots.stability.setHistory( History() ); // stability tests may last for days
+    plots.test.graph().SetName( ( graph_prefix+"test" ).c_str() );
+    plots.test.graph().SetTitle( ";Timestamp (s);Leakage current (pA)" );
+  }
+}
+
+void
+GuiOutput::addReading( unsigned short station, unsigned short, double, const Reading& reading )
+{
+  if ( test_mode_ )
+    plots_.at( station ).test.addPoint( reading.timestamp, reading.value*1.e12 );
+}
+
+void
+GuiOutput::addStage( unsigned short station, unsigned short stage, double voltage, double mean, double stdev, unsigned int )
+{
+  plots_.at( station ).meas.setPoint( stage, voltage, mean, stdev );
+}
+
+void
+GuiOutput::addStabilityPoint( unsigned short station, double time, double current )
+{
+  plots_.at( station ).stability.addPoint( time, current );
+}
+
+void
+GuiOutput::draw( unsigned short station, TVirtualPad* pad_meas, TVirtualPad* pad_stab )
+{
+  plots_.at( station ).meas.draw( pad_meas );
+  plots_.at( station ).stability.draw( pad_stab );
+}
+
+void
+GuiOutput::drawTest( unsigned short station, TVirtualPad* pad, TH1* hist, TVirtualPad* hist_pad )
+{
+  test_mode_ = true;
+  plots_.at( station ).test.draw( pad );
+  plots_.at( station ).test.setHistogram( hist, hist_pad );
+}
+
+void
+GuiOutput::detach()
+{
+  for ( auto& plots : plots_ ) {
+    plots.meas.detach();
+    plots.stability.detach();
+    plots.test.detach();
+  }
+}
+
+void
+GuiOutput::refresh()
+{
+  for ( auto& plots : plots_ ) {
+    plots.meas.refresh();
+    plots.stability.refresh();
+    plots.test.refresh();
+  }
+}
@@ -0,0 +1,145 @@
+#include "ivutils/History.h"
+
+#include <stdexcept>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+using namespace ivutils;
+
+const size_t History::DEFAULT_RAW_CAPACITY = 1000;
+const size_t History::DEFAULT_NUM_BUCKETS = 500;
+
+History::History( size_t raw_capacity, size_t num_buckets ) :
+  raw_capacity_( raw_capacity ), num_buckets_( num_buckets ),
+  raw_begin_( 0 ), bucket_width_( 1 ), count_( 0 )
+{
+  if ( raw_capacity_ < 1 || num_buckets_ < 2 )
+    throw std::runtime_error( "Invalid history size: "+std::to_string( raw_capacity_ )+" points, "
+      +std::to_string( num_buckets_ )+" buckets!" );
+  raw_.reserve( raw_capacity_ );
+  buckets_.reserve( num_buckets_ );
+}
+
+void
+History::clear()
+{
+  raw_.clear();
+  raw_begin_ = 0;
+  buckets_.clear();
+  bucket_width_ = 1;
+  count_ = 0;
+}
+
+void
+History::add( double x, double y )
+{
+  ++count_;
+  if ( raw_.size() < raw_capacity_ ) {
+    raw_.emplace_back( Point{ x, y } );
+    return;
+  }
+  //--- ring buffer is full; the oldest point is summarised, and replaced
+  aggregate( raw_.at( raw_begin_ ) );
+  raw_.at( raw_begin_ ) = Point{ x, y };
+  raw_begin_ = ( raw_begin_+1 ) % raw_capacity_;
+}
+
+void
+History::aggregate( const Point& point )
+{
+  if ( !buckets_.empty() && buckets_.back().count < bucket_width_ ) {
+    auto& bucket = buckets_.back();
+    bucket.x_last = point.x;
+    bucket.count++;
+    bucket.sum += point.y;
+    if ( point.y < bucket.low.y )
+      bucket.low = point;
+    if ( point.y > bucket.high.y )
+      bucket.high = point;
+    return;
+  }
+  if ( buckets_.size() == num_buckets_ ) {
+    //--- all buckets used; halve the resolution by merging pairs of neighbours
+    size_t j = 0;
+    for ( size_t i = 0; i < buckets_.size(); i += 2, ++j ) {
+      Bucket merged = buckets_.at( i );
+      if ( i+1 < buckets_.size() ) {
+        const auto& next = buckets_.at( i+1 );
+        merged.x_last = next.x_last;
+        merged.count += next.count;
+        merged.sum += next.sum;
+        if ( next.low.y < merged.low.y )
+          merged.low = next.low;
+        if ( next.high.y > merged.high.y )
+          merged.high = next.high;
+      }
+      buckets_.at( j ) = merged;
+    }
+    buckets_.resize( j );
+    bucket_width_ *= 2;
+  }
+  buckets_.emplace_back( Bucket{ point.x, point.x, 1, point.y, point, point } );
+}
+
+void
+History::points( std::vector<Point>& points ) const
+{
+  points.clear();
+  for ( const auto& bucket : buckets_ ) {
+    //--- both extrema are kept, in their chronological order, to preserve spikes
+    if ( bucket.low.x <= bucket.high.x ) {
+      points.emplace_back( bucket.low );
+      if ( bucket.count > 1 )
+        points.emplace_back( bucket.high );
+    }
+    else {
+      points.emplace_back( bucket.high );
+      points.emplace_back( bucket.low );
+    }
+  }
+  for ( size_t i = 0; i < raw_.size(); ++i )
+    points.emplace_back( raw_.at( ( raw_begin_+i ) % raw_.size() ) );
+}
+
+void
+History::decimate( const std::vector<Point>& in, size_t threshold, std::vector<Point>& out )
+{
+  out.clear();
+  if ( threshold < 3 || in.size() <= threshold ) {
+    out = in;
+    return;
+  }
+  //--- first and last points are always kept; all others are split into
+  //    threshold-2 buckets, each represented by the point forming the largest
+  //    triangle with the previously selected point and the next bucket average
+  const double every = (double)( in.size()-2 )/( threshold-2 );
+  size_t a = 0;
+  out.emplace_back( in.front() );
+  for ( size_t i = 0; i < threshold-2; ++i ) {
+    const size_t next_begin = std::min<size_t>( (size_t)( ( i+1 )*every )+1, in.size()-1 );
+    const size_t next_end = std::min<size_t>( (size_t)( ( i+2 )*every )+1, in.size() );
+    double avg_x = 0., avg_y = 0.;
+    for ( size_t j = next_begin; j < next_end; ++j ) {
+      avg_x += in.at( j ).x;
+      avg_y += in.at( j ).y;
+    }
+    const double num_next = std::max<size_t>( next_end-next_begin, 1 );
+    avg_x /= num_next;
+    avg_y /= num_next;
+    const size_t begin = (size_t)( i*every )+1, end = std::min<size_t>( (size_t)( ( i+1 )*every )+1, in.size()-1 );
+    double max_area = -1.;
+    size_t selected = begin;
+    for ( size_t j = begin; j < end; ++j ) {
+      const double area = std::fabs( ( in.at( a ).x-avg_x )*( in.at( j ).y-in.at( a ).y )
+                                    -( in.at( a ).x-in.at( j ).x )*( avg_y-in.at( a ).y ) );
+      if ( area > max_area ) {
+        max_area = area;
+        selected = j;
+      }
+    }
+    out.emplace_back( in.at( selected ) );
+    a = selected;
+  }
+  out.emplace_back( in.back() );
+}
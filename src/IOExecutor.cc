@@ -0,0 +1,51 @@
+#include "ivutils/IOExecutor.h"
+
+#include <algorithm>
+
+using namespace ivutils;
+
+IOExecutor::IOExecutor() :
+  next_sequence_( 0 ), stop_( false ), worker_id_( std::thread::id() )
+{}
+
+IOExecutor::~IOExecutor()
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    stop_ = true;
+  }
+  cond_.notify_one();
+  if ( thread_.joinable() )
+    thread_.join();
+}
+
+void
+IOExecutor::promote( const Priority& priority )
+{
+  bool promoted = false;
+  for ( auto& task : tasks_ )
+    if ( task.ordered && task.priority > priority ) {
+      task.priority = priority; // submission order is then preserved
+      promoted = true;
+    }
+  if ( promoted )
+    std::make_heap( tasks_.begin(), tasks_.end() );
+}
+
+void
+IOExecutor::run()
+{
+  while ( true ) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock( mutex_ );
+      cond_.wait( lock, [this]() { return stop_ || !tasks_.empty(); } );
+      if ( tasks_.empty() ) // stop requested, and nothing left to run
+        return;
+      std::pop_heap( tasks_.begin(), tasks_.end() );
+      task = std::move( tasks_.back().run );
+      tasks_.pop_back();
+    }
+    task(); // exceptions are forwarded to the task future
+  }
+}
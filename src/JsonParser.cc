@@ -0,0 +1,283 @@
+#include "ivutils/JsonParser.h"
+
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+using namespace ivutils;
+
+namespace
+{
+  /// Single-pass recursive descent reader over a JSON document
+  class Reader
+  {
+    public:
+      explicit Reader( const StringView& content ) :
+        begin_( content.begin() ), pos_( content.begin() ), end_( content.end() ) {}
+
+      /// Parse the top-level object
+      ParametersList document() {
+        ParametersList out = object();
+        skipSpaces();
+        if ( pos_ != end_ )
+          error( "unexpected content after the top-level object" );
+        return out;
+      }
+
+    private:
+      [[noreturn]] void error( const std::string& message ) const {
+        size_t line = 1, column = 1;
+        for ( const char* it = begin_; it < pos_; ++it, ++column )
+          if ( *it == '\n' ) {
+            ++line;
+            column = 0;
+          }
+        std::ostringstream os;
+        os << "JsonParser: " << message << " (line " << line << ", column " << column << ")!";
+        throw std::runtime_error( os.str() );
+      }
+      /// Skip all whitespaces and comments
+      void skipSpaces() {
+        while ( pos_ < end_ ) {
+          if ( *pos_ == '#' ) { // comment, up to the end of line
+            while ( pos_ < end_ && *pos_ != '\n' )
+              ++pos_;
+          }
+          else if ( *pos_ == ' ' || *pos_ == '\t' || *pos_ == '\n' || *pos_ == '\r' )
+            ++pos_;
+          else
+            break;
+        }
+      }
+      /// Next significant character, without consuming it
+      char peek() {
+        skipSpaces();
+        if ( pos_ == end_ )
+          error( "unexpected end of document" );
+        return *pos_;
+      }
+      void expect( char c ) {
+        if ( peek() != c )
+          error( std::string( "expecting '" )+c+"'" );
+        ++pos_;
+      }
+      /// Consume a character if it is the next significant one
+      bool accept( char c ) {
+        if ( peek() != c )
+          return false;
+        ++pos_;
+        return true;
+      }
+      /// Consume a literal keyword (true, false, or null)
+      bool keyword( const char* word ) {
+        const size_t len = strlen( word );
+        if ( (size_t)( end_-pos_ ) < len || memcmp( pos_, word, len ) != 0 )
+          return false;
+        pos_ += len;
+        return true;
+      }
+
+      /// Parse a string
+      /// \param[out] buffer Decoded string storage, only used if escape sequences are found
+      /// \return View on the raw characters, or on the decoded buffer
+      StringView string( std::string& buffer ) {
+        expect( '"' );
+        const char* start = pos_;
+        while ( pos_ < end_ && *pos_ != '"' && *pos_ != '\\' )
+          ++pos_;
+        if ( pos_ == end_ )
+          error( "unterminated string" );
+        if ( *pos_ == '"' ) // no escape sequence; view on the document
+          return StringView( start, ( pos_++ )-start );
+        buffer.assign( start, pos_ );
+        while ( pos_ < end_ && *pos_ != '"' ) {
+          if ( *pos_ != '\\' ) {
+            buffer.push_back( *pos_++ );
+            continue;
+          }
+          if ( ++pos_ == end_ )
+            break;
+          switch ( *pos_++ ) {
+            case '"': buffer.push_back( '"' ); break;
+            case '\\': buffer.push_back( '\\' ); break;
+            case '/': buffer.push_back( '/' ); break;
+            case 'b': buffer.push_back( '\b' ); break;
+            case 'f': buffer.push_back( '\f' ); break;
+            case 'n': buffer.push_back( '\n' ); break;
+            case 'r': buffer.push_back( '\r' ); break;
+            case 't': buffer.push_back( '\t' ); break;
+            case 'u': {
+              if ( end_-pos_ < 4 )
+                error( "invalid unicode escape sequence" );
+              const unsigned long code = strtoul( std::string( pos_, 4 ).c_str(), nullptr, 16 );
+              pos_ += 4;
+              //--- UTF-8 encoding of a basic multilingual plane code point
+              if ( code < 0x80 )
+                buffer.push_back( code );
+              else if ( code < 0x800 ) {
+                buffer.push_back( 0xc0 | ( code >> 6 ) );
+                buffer.push_back( 0x80 | ( code & 0x3f ) );
+              }
+              else {
+                buffer.push_back( 0xe0 | ( code >> 12 ) );
+                buffer.push_back( 0x80 | ( ( code >> 6 ) & 0x3f ) );
+                buffer.push_back( 0x80 | ( code & 0x3f ) );
+              }
+            } break;
+            default: error( "invalid escape sequence" );
+          }
+        }
+        if ( pos_ == end_ )
+          error( "unterminated string" );
+        ++pos_;
+        return StringView( buffer );
+      }
+      /// Parse a number
+      /// \param[out] integer True if the number has no fractional part nor exponent
+      double number( bool& integer ) {
+        skipSpaces();
+        const char* start = pos_;
+        integer = true;
+        if ( pos_ < end_ && ( *pos_ == '-' || *pos_ == '+' ) )
+          ++pos_;
+        while ( pos_ < end_ && ( isdigit( *pos_ ) || *pos_ == '.' || *pos_ == 'e' || *pos_ == 'E'
+          || ( ( *pos_ == '-' || *pos_ == '+' ) && ( pos_[-1] == 'e' || pos_[-1] == 'E' ) ) ) ) {
+          if ( !isdigit( *pos_ ) )
+            integer = false;
+          ++pos_;
+        }
+        if ( pos_ == start )
+          error( "invalid value" );
+        //--- the number is delimited beforehand, as the document is not null-terminated
+        char buf[64];
+        const size_t len = pos_-start;
+        if ( len >= sizeof( buf ) )
+          error( "number too long" );
+        memcpy( buf, start, len );
+        buf[len] = '\0';
+        char* num_end = nullptr;
+        const double value = strtod( buf, &num_end );
+        if ( num_end != buf+len )
+          error( "invalid number" );
+        //--- integers beyond the parameters range are kept as floating point values
+        if ( value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max() )
+          integer = false;
+        return value;
+      }
+      /// Parse an object into a parameters list
+      ParametersList object() {
+        ParametersList out;
+        expect( '{' );
+        std::string key_buffer, value_buffer;
+        while ( !accept( '}' ) ) {
+          const StringView key = string( key_buffer );
+          expect( ':' );
+          const char c = peek();
+          if ( c == '{' )
+            out.set<ParametersList>( key, object() );
+          else if ( c == '[' )
+            array( out, key );
+          else if ( c == '"' )
+            out.set<std::string>( key, string( value_buffer ).str() );
+          else if ( keyword( "true" ) )
+            out.set<int>( key, 1 );
+          else if ( keyword( "false" ) )
+            out.set<int>( key, 0 );
+          else if ( !keyword( "null" ) ) {
+            bool integer = false;
+            const double value = number( integer );
+            if ( integer )
+              out.set<int>( key, value );
+            else
+              out.set<double>( key, value );
+          }
+          if ( !accept( ',' ) ) {
+            expect( '}' );
+            break;
+          }
+        }
+        return out;
+      }
+      /// Parse a homogeneous array into a vector parameter
+      void array( ParametersList& out, const StringView& key ) {
+        expect( '[' );
+        if ( accept( ']' ) )
+          return; // no type can be deduced
+        const char first = peek();
+        if ( first == '{' ) {
+          std::vector<ParametersList> vec;
+          do {
+            if ( peek() == ']' )
+              break; // trailing comma
+            vec.emplace_back( object() );
+          } while ( accept( ',' ) );
+          out.set<std::vector<ParametersList> >( key, vec );
+        }
+        else if ( first == '"' ) {
+          std::vector<std::string> vec;
+          std::string buffer;
+          do {
+            if ( peek() == ']' )
+              break;
+            vec.emplace_back( string( buffer ).str() );
+          } while ( accept( ',' ) );
+          out.set<std::vector<std::string> >( key, vec );
+        }
+        else if ( first == '[' )
+          error( "nested arrays are not supported" );
+        else {
+          std::vector<double> vec;
+          bool all_integers = true;
+          do {
+            if ( peek() == ']' )
+              break;
+            bool integer = true;
+            if ( keyword( "true" ) )
+              vec.emplace_back( 1. );
+            else if ( keyword( "false" ) )
+              vec.emplace_back( 0. );
+            else {
+              vec.emplace_back( number( integer ) );
+              all_integers = all_integers && integer;
+            }
+          } while ( accept( ',' ) );
+          if ( all_integers )
+            out.set<std::vector<int> >( key, std::vector<int>( vec.begin(), vec.end() ) );
+          else
+            out.set<std::vector<double> >( key, vec );
+        }
+        expect( ']' );
+      }
+
+      const char* begin_;
+      const char* pos_;
+      const char* end_;
+  };
+}
+
+JsonParser::JsonParser( const char* config_file )
+{
+  std::ifstream file( config_file, std::ios::binary );
+  if ( !file )
+    throw std::runtime_error( "JsonParser: Failed to open the configuration card \""+std::string( config_file )+"\"!" );
+  //--- read the whole card at once
+  file.seekg( 0, std::ios::end );
+  const std::streamoff size = file.tellg();
+  //--- non-seekable streams report a negative size, and directories an arbitrary one
+  if ( size < 0 || (unsigned long long)size >= std::string().max_size() )
+    throw std::runtime_error( "JsonParser: Failed to read the configuration card \""+std::string( config_file )+"\"!" );
+  std::string content( size, '\0' );
+  file.seekg( 0, std::ios::beg );
+  if ( !file.read( &content[0], size ) )
+    throw std::runtime_error( "JsonParser: Failed to read the configuration card \""+std::string( config_file )+"\"!" );
+  ParametersList::operator+=( parse( content ) );
+}
+
+ParametersList
+JsonParser::parse( const StringView& content )
+{
+  return Reader( content ).document();
+}
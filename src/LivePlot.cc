@@ -0,0 +1,113 @@
+#include "ivutils/LivePlot.h"
+
+#include "TVirtualPad.h"
+#include "TH1.h"
+
+using namespace ivutils;
+
+const size_t LivePlot::DEFAULT_DISPLAY_POINTS = 1000;
+
+LivePlot::LivePlot() :
+  clear_pending_( false ), display_points_( DEFAULT_DISPLAY_POINTS ), history_modified_( false ),
+  pad_( nullptr ), hist_( nullptr ), hist_pad_( nullptr )
+{}
+
+void
+LivePlot::setHistory( const History& history, size_t display_points )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  history_.reset( new History( history ) );
+  display_points_ = display_points;
+}
+
+void
+LivePlot::setPoint( size_t i, double x, double y, double ey )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  pending_.emplace_back( Point{ (long)i, x, y, ey } );
+}
+
+void
+LivePlot::addPoint( double x, double y, double ey )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  if ( history_ ) {
+    history_->add( x, y );
+    history_modified_ = true;
+    return;
+  }
+  pending_.emplace_back( Point{ -1, x, y, ey } );
+}
+
+void
+LivePlot::clear()
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  pending_.clear();
+  clear_pending_ = true;
+  if ( history_ )
+    history_->clear();
+}
+
+void
+LivePlot::draw( TVirtualPad* pad, const char* option )
+{
+  pad_ = pad;
+  pad_->cd();
+  graph_.Draw( option );
+}
+
+void
+LivePlot::setHistogram( TH1* hist, TVirtualPad* pad )
+{
+  hist_ = hist;
+  hist_pad_ = pad;
+  hist_pad_->cd();
+  hist_->Draw();
+}
+
+bool
+LivePlot::refresh()
+{
+  bool cleared = false, history_modified = false;
+  { //--- only hold the acquisition-side lock for the buffers swap (or the bounded history copy)
+    std::lock_guard<std::mutex> lock( mutex_ );
+    rendering_.swap( pending_ );
+    std::swap( cleared, clear_pending_ );
+    std::swap( history_modified, history_modified_ );
+    if ( history_modified )
+      history_->points( history_points_ );
+  }
+  if ( !cleared && !history_modified && rendering_.empty() )
+    return false;
+  if ( cleared ) {
+    graph_.Set( 0 );
+    if ( hist_ )
+      hist_->Reset();
+  }
+  for ( const auto& pt : rendering_ ) {
+    const int i = pt.index < 0 ? graph_.GetN() : pt.index;
+    graph_.SetPoint( i, pt.x, pt.y );
+    graph_.SetPointError( i, 0., pt.ey );
+    if ( hist_ )
+      hist_->Fill( pt.y );
+  }
+  rendering_.clear(); // capacity is kept for the next refresh
+  if ( history_modified ) { //--- the whole (decimated) history is redrawn
+    History::decimate( history_points_, display_points_, display_ );
+    graph_.Set( display_.size() );
+    for ( size_t i = 0; i < display_.size(); ++i ) {
+      graph_.SetPoint( i, display_.at( i ).x, display_.at( i ).y );
+      graph_.SetPointError( i, 0., 0. );
+    }
+  }
+  if ( pad_ ) {
+    pad_->Modified();
+    pad_->Update();
+  }
+  if ( hist_pad_ ) {
+    hist_pad_->Modified();
+    hist_pad_->Update();
+  }
+  return true;
+}
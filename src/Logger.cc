@@ -0,0 +1,277 @@
+#include "ivutils/Logger.h"
+
+#include <ctime>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+using namespace ivutils;
+
+namespace
+{
+  /// Reusable stream, formatting a message into a string
+  class MessageStream : private std::streambuf, public std::ostream
+  {
+    public:
+      MessageStream() : std::ostream( this ) {}
+      /// Prepare the stream for a new message
+      std::ostream& reset() {
+        clear();
+        flags( std::ios_base::dec | std::ios_base::skipws );
+        precision( 6 );
+        width( 0 );
+        fill( ' ' );
+        message.clear(); // capacity is kept
+        return *this;
+      }
+      std::string message;
+
+    private:
+      std::streambuf::int_type overflow( std::streambuf::int_type c ) override {
+        if ( c != std::streambuf::traits_type::eof() )
+          message.push_back( std::streambuf::traits_type::to_char_type( c ) );
+        return c;
+      }
+      std::streamsize xsputn( const char* str, std::streamsize num ) override {
+        message.append( str, num );
+        return num;
+      }
+  };
+  /// Formatting streams of the current thread, one per nesting level
+  /// (a message may be built while formatting another one)
+  thread_local std::vector<std::unique_ptr<MessageStream> > thread_streams;
+  thread_local size_t thread_depth = 0;
+}
+
+const size_t Logger::RING_SIZE = 1024;
+std::atomic<int> Logger::level_( info );
+
+Logger&
+Logger::get()
+{
+  static Logger logger;
+  return logger;
+}
+
+Logger::Logger() :
+  ring_( new Record[RING_SIZE] ),
+  enqueue_pos_( 0 ), dequeue_pos_( 0 ), num_dropped_( 0 ), running_( true ), sleeping_( false )
+{
+  for ( size_t i = 0; i < RING_SIZE; ++i )
+    ring_[i].sequence.store( i, std::memory_order_relaxed );
+  thread_ = std::thread( &Logger::run, this );
+}
+
+Logger::~Logger()
+{
+  running_ = false;
+  {
+    std::lock_guard<std::mutex> lock( wake_mutex_ );
+    wake_cond_.notify_one();
+  }
+  if ( thread_.joinable() )
+    thread_.join();
+  //--- write the remaining messages
+  while ( writeBatch() > 0 ) {}
+}
+
+LogMessageType
+Logger::level( const std::string& name )
+{
+  if ( name == "error" )
+    return error;
+  if ( name == "warning" )
+    return warning;
+  if ( name == "info" )
+    return info;
+  if ( name == "debug" )
+    return debug;
+  throw std::runtime_error( "Invalid log level: \""+name+"\". Valid levels are \"error\", \"warning\", \"info\", and \"debug\"." );
+}
+
+void
+Logger::setOutputFile( const std::string& filename )
+{
+  flush();
+  bool opened = false;
+  {
+    std::lock_guard<std::mutex> lock( write_mutex_ );
+    file_.open( filename, std::ios::out | std::ios::app );
+    opened = file_.is_open();
+  }
+  if ( !opened )
+    push( warning, "Failed to open the log file \""+filename+"\"!" );
+}
+
+void
+Logger::push( const LogMessageType& type, std::string&& message )
+{
+  while ( !tryPush( type, message ) ) {
+    //--- ring is full; never block the acquisition for informational or debugging messages
+    if ( type >= info ) {
+      ++num_dropped_;
+      return;
+    }
+    wake();
+    std::this_thread::yield();
+  }
+  wake();
+}
+
+void
+Logger::wake()
+{
+  //--- pairs with the fence of the writing thread before it checks for messages:
+  //    either the new message is seen there, or the thread is seen sleeping here
+  std::atomic_thread_fence( std::memory_order_seq_cst );
+  if ( !sleeping_.load( std::memory_order_relaxed ) )
+    return;
+  std::lock_guard<std::mutex> lock( wake_mutex_ );
+  wake_cond_.notify_one();
+}
+
+bool
+Logger::available() const
+{
+  const size_t pos = dequeue_pos_.load( std::memory_order_acquire );
+  return ring_[pos & ( RING_SIZE-1 )].sequence.load( std::memory_order_acquire ) == pos+1;
+}
+
+bool
+Logger::tryPush( const LogMessageType& type, std::string& message )
+{
+  const auto now = std::chrono::system_clock::now();
+  size_t pos = enqueue_pos_.load( std::memory_order_relaxed );
+  Record* rec = nullptr;
+  while ( true ) {
+    rec = &ring_[pos & ( RING_SIZE-1 )];
+    const size_t seq = rec->sequence.load( std::memory_order_acquire );
+    const long diff = (long)seq-(long)pos;
+    if ( diff == 0 ) { // free slot; try to claim it
+      if ( enqueue_pos_.compare_exchange_weak( pos, pos+1, std::memory_order_relaxed ) )
+        break;
+    }
+    else if ( diff < 0 ) // ring is full
+      return false;
+    else // another producer claimed this slot
+      pos = enqueue_pos_.load( std::memory_order_relaxed );
+  }
+  rec->type = type;
+  rec->time = now;
+  rec->message.swap( message );
+  rec->sequence.store( pos+1, std::memory_order_release );
+  return true;
+}
+
+void
+Logger::flush()
+{
+  const size_t target = enqueue_pos_.load( std::memory_order_acquire );
+  while ( dequeue_pos_.load( std::memory_order_acquire ) < target )
+    if ( writeBatch() == 0 )
+      std::this_thread::yield(); // a slot is claimed, but its message is not stored yet
+}
+
+size_t
+Logger::writeBatch()
+{
+  std::lock_guard<std::mutex> lock( write_mutex_ );
+  batch_.clear();
+  size_t num_written = 0;
+  if ( num_dropped_ > 0 ) {
+    batch_ += "[WARNING] "+std::to_string( num_dropped_.exchange( 0 ) )+" log message(s) dropped.\n";
+    ++num_written;
+  }
+  size_t pos = dequeue_pos_.load( std::memory_order_relaxed );
+  while ( true ) {
+    Record& rec = ring_[pos & ( RING_SIZE-1 )];
+    if ( rec.sequence.load( std::memory_order_acquire ) != pos+1 )
+      break; // no more message available
+    //--- timestamp and format the record
+    const std::time_t time = std::chrono::system_clock::to_time_t( rec.time );
+    const long ms = std::chrono::duration_cast<std::chrono::milliseconds>( rec.time.time_since_epoch() ).count() % 1000;
+    std::tm tm;
+    localtime_r( &time, &tm );
+    char timestamp[32];
+    snprintf( timestamp, sizeof( timestamp ), "%02d:%02d:%02d.%03ld ", tm.tm_hour, tm.tm_min, tm.tm_sec, ms );
+    batch_ += timestamp;
+    switch ( rec.type ) {
+      case error: batch_ += "[ERROR]"; break;
+      case warning: batch_ += "[WARNING]"; break;
+      case info: batch_ += "[INFO]"; break;
+      case debug: batch_ += "[DEBUG]"; break;
+    }
+    batch_ += " ";
+    batch_ += rec.message;
+    batch_ += "\n";
+    rec.message.clear();
+    //--- release the slot for the next ring cycle
+    rec.sequence.store( pos+RING_SIZE, std::memory_order_release );
+    dequeue_pos_.store( ++pos, std::memory_order_release );
+    ++num_written;
+  }
+  if ( batch_.empty() )
+    return 0;
+  std::cout.write( batch_.data(), batch_.size() );
+  std::cout.flush();
+  if ( file_.is_open() ) {
+    file_.write( batch_.data(), batch_.size() );
+    file_.flush();
+  }
+  return num_written;
+}
+
+void
+Logger::run()
+{
+  while ( running_ ) {
+    if ( writeBatch() > 0 )
+      continue;
+    //--- wait for the next message
+    std::unique_lock<std::mutex> lock( wake_mutex_ );
+    sleeping_.store( true, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    wake_cond_.wait( lock, [this]() { return !running_ || available() || num_dropped_ > 0; } );
+    sleeping_.store( false, std::memory_order_relaxed );
+  }
+}
+
+//--- messages formatting
+
+LogMessage::LogMessage( const LogMessageType& type ) :
+  type_( type ), num_suppressed_( 0 ), message_( nullptr )
+{
+  if ( Logger::enabled( type ) )
+    open();
+}
+
+LogMessage::LogMessage( const LogMessageType& type, LogRateLimiter& limiter ) :
+  type_( type ), num_suppressed_( 0 ), message_( nullptr )
+{
+  if ( Logger::enabled( type ) && limiter.allow( num_suppressed_ ) )
+    open();
+}
+
+LogMessage::~LogMessage()
+{
+  if ( !message_ )
+    return;
+  if ( num_suppressed_ > 0 )
+    *message_ << " (" << num_suppressed_ << " similar message(s) suppressed)";
+  //--- the string is exchanged with the one of a recycled ring slot, keeping its capacity
+  std::string& message = thread_streams[--thread_depth]->message;
+  Logger::get().push( type_, std::move( message ) );
+  message.clear();
+  //--- errors are written at once; stopping the program is left to the
+  //    caller, as the message may be emitted from a worker thread
+  if ( type_ == error )
+    Logger::get().flush();
+}
+
+void
+LogMessage::open()
+{
+  if ( thread_depth == thread_streams.size() )
+    thread_streams.emplace_back( new MessageStream );
+  message_ = &thread_streams[thread_depth++]->reset();
+}
@@ -1,10 +1,12 @@
 #include "ivutils/Messenger.h"
 #include "ivutils/ParametersList.h"
+#include "ivutils/Logger.h"
 
 #include <exception>
 #include <sstream>
 #include <thread>
 #include <chrono>
+#include <algorithm>
 
 #if defined GPIB
 # include <gpib/ib.h>
@@ -15,12 +17,49 @@
 using namespace ivutils;
 
 const unsigned short Messenger::ACK_TIME_MS = 20;
+const unsigned int Messenger::DEFAULT_TIMEOUT_MS = 3000;
+const size_t Messenger::DEFAULT_INPUT_BUFFER_SIZE = 256;
+const char Messenger::STB_MAV = 0x10;
+const unsigned short Messenger::POLL_INTERVAL_US = 200;
+const size_t Messenger::READ_CHUNK_SIZE = 512;
 
-Messenger::Messenger( int prim_addr, int second_addr ) :
-  device_( -1 )
+#if defined NI4882 || defined GPIB
+namespace
+{
+  /// Convert a duration (in ms) into the closest (upper) GPIB timeout code
+  int
+  timeoutCode( unsigned int timeout_ms )
+  {
+    static const unsigned long long codes_us[] = {
+      10ull, 30ull, 100ull, 300ull, 1000ull, 3000ull, 10000ull, 30000ull, 100000ull, 300000ull,
+      1000000ull, 3000000ull, 10000000ull, 30000000ull, 100000000ull, 300000000ull, 1000000000ull
+    };
+    const unsigned long long timeout_us = timeout_ms*1000ull;
+    for ( int i = 0; i < 17; ++i )
+      if ( codes_us[i] >= timeout_us )
+        return T10us+i;
+    return T1000s;
+  }
+
+  /// Set the I/O timeout of a device
+  /// \return Timeout code previously in use, to be restored afterwards
+  int
+  swapTimeout( int device, int code )
+  {
+    int previous = T3s;
+    ibask( device, IbaTMO, &previous );
+    ibtmo( device, code );
+    return previous;
+  }
+}
+#endif
+
+Messenger::Messenger( int prim_addr, int second_addr, int board_index ) :
 #ifdef EMULATE
-  , cmd_file_( "commands.out", std::ios::out )
+  cmd_file_( "commands.out", std::ios::out ),
 #endif
+  input_buffer_size_( DEFAULT_INPUT_BUFFER_SIZE ),
+  device_( -1 ), completion_mode_( fixedDelay ), timeout_ms_( DEFAULT_TIMEOUT_MS )
 {
   if ( prim_addr < 0 )
     return;
@@ -34,11 +73,16 @@ Messenger::Messenger( int prim_addr, int second_addr ) :
     os << "Secondary address must be comprised between 0 and 15. Current value: " << second_addr << ".";
     throw std::runtime_error( os.str() );
   }
+  if ( board_index < 0 ) {
+    std::ostringstream os;
+    os << "Board index must be positive. Current value: " << board_index << ".";
+    throw std::runtime_error( os.str() );
+  }
 #if defined NI4882 || defined GPIB
   char* version_chr;
   ibvers( &version_chr );
-  LogMessage( info ) << "GPIB version " << version_chr << " initialised.";
-  const int board_index = 0, send_eoi = 1, eos_mode = 0;
+  IVUTILS_LOG( info ) << "GPIB version " << version_chr << " initialised.";
+  const int send_eoi = 1, eos_mode = 0;
   const int timeout = T3s; // TNONE?
   device_ = ibdev( board_index, prim_addr, second_addr, timeout, send_eoi, eos_mode );
   if ( device_ < 0 ) {
@@ -50,7 +94,7 @@ Messenger::Messenger( int prim_addr, int second_addr ) :
     throw std::runtime_error( os.str() );
   }
   clear();
-  LogMessage( info ) << "Device is alive and kicking!\n"
+  IVUTILS_LOG( info ) << "Device is alive and kicking!\n"
     << "  board index: " << board_index << "\n"
     << "  addresses: primary: " << prim_addr << ", secondary: " << second_addr << ".";
 #endif
@@ -58,9 +102,11 @@ Messenger::Messenger( int prim_addr, int second_addr ) :
 
 Messenger::~Messenger()
 {
+  if ( executor_.started() )
+    execute( []() {} ); // wait for all pending operations
 #if defined NI4882 || defined GPIB
   if ( device_ >= 0 && ibonl( device_, 1 ) & ERR )
-    LogMessage( error ) << "Failed to reset the board to its default state!";
+    IVUTILS_LOG( error ) << "Failed to reset the board to its default state!";
 #endif
 }
 
@@ -77,15 +123,91 @@ Messenger::clear() const
       << "GPIB error: " << gpib_error_string( ThreadIberr() );
     throw std::runtime_error( os.str() );
   }
-  LogMessage( info ) << "Device clear sent " << res << ".";
+  IVUTILS_LOG( debug ) << "Device clear sent " << res << ".";
 #endif
 }
 
+Messenger::CompletionMode
+Messenger::completionMode( const std::string& name )
+{
+  if ( name == "delay" )
+    return fixedDelay;
+  if ( name == "poll" )
+    return serialPoll;
+  if ( name == "srq" )
+    return serviceRequest;
+  throw std::runtime_error( "Invalid completion mode: \""+name+"\". Valid modes are \"delay\", \"poll\", and \"srq\"." );
+}
+
+void
+Messenger::setCompletionMode( const CompletionMode& mode, unsigned int timeout_ms )
+{
+  execute( [&]() {
+    completion_mode_ = mode;
+    timeout_ms_ = timeout_ms;
+    //--- let the module assert a service request as soon as a message is available
+    if ( mode == serviceRequest )
+      send( "*SRE 16" );
+  } );
+}
+
+void
+Messenger::setInputBufferSize( size_t size )
+{
+  execute( [this, size]() { input_buffer_size_ = size; } );
+}
+
 void
 Messenger::send( std::string msg ) const
+{
+  execute( [&]() {
+    flush();
+    write( msg );
+  } );
+}
+
+std::future<void>
+Messenger::sendAsync( const std::string& msg, const IOExecutor::Priority& priority, unsigned int deadline_ms ) const
+{
+  return executeAsync( [this, msg]() { send( msg ); }, priority, deadline_ms );
+}
+
+void
+Messenger::queue( const std::string& msg ) const
+{
+  if ( msg.empty() )
+    return;
+  execute( [&]() {
+    //--- ensure each command is interpreted from the root of the command tree
+    const bool from_root = ( msg[0] == ':' || msg[0] == '*' );
+    const size_t cmd_size = msg.size()+( from_root ? 0 : 1 );
+    if ( !pending_commands_.empty() && pending_commands_.size()+cmd_size+2 > input_buffer_size_ )
+      flush(); // ';' separator and message terminator would not fit
+    if ( !pending_commands_.empty() )
+      pending_commands_ += ';';
+    if ( !from_root )
+      pending_commands_ += ':';
+    pending_commands_ += msg;
+  } );
+}
+
+void
+Messenger::flush() const
+{
+  execute( [this]() {
+    if ( pending_commands_.empty() )
+      return;
+    write( pending_commands_ );
+    pending_commands_.clear();
+  } );
+}
+
+void
+Messenger::write( const std::string& msg ) const
 {
 #if defined EMULATE
   cmd_file_ << msg << "\n";
+  settings_.update( msg );
 #elif defined NI4882 || defined GPIB
   const std::string out_msg = msg+"\n";
   const int res = ibwrt( device_, out_msg.c_str(), out_msg.size() );
@@ -98,46 +220,168 @@ Messenger::send( std::string msg ) const
       << "GPIB error: " << gpib_error_string( ThreadIberr() );
     throw std::runtime_error( os.str() );
   }
-  last_command_ = msg;
+  settings_.update( msg );
 #endif
 }
 
 std::vector<std::string>
-Messenger::fetch( const std::string& msg ) const
+Messenger::fetch( const std::string& msg, unsigned int timeout_ms ) const
 {
-  send( msg );
-  std::this_thread::sleep_for( std::chrono::milliseconds( ACK_TIME_MS ) );
-  return receive();
+  return execute( [&]() {
+    std::vector<StringView> lines;
+    fetch( msg, lines, timeout_ms );
+    std::vector<std::string> out;
+    out.reserve( lines.size() );
+    for ( const auto& line : lines )
+      out.emplace_back( line.str() );
+    return out;
+  } );
 }
 
-std::vector<std::string>
-Messenger::receive() const
+std::future<std::vector<std::string> >
+Messenger::fetchAsync( const std::string& msg, unsigned int timeout_ms, const IOExecutor::Priority& priority, unsigned int deadline_ms ) const
+{
+  return executeAsync( [this, msg, timeout_ms]() { return fetch( msg, timeout_ms ); }, priority, deadline_ms );
+}
+
+char
+Messenger::statusByte() const
+{
+  return execute( [this]() { return serialPollByte(); }, IOExecutor::safety, false );
+}
+
+std::future<char>
+Messenger::statusByteAsync( unsigned int deadline_ms ) const
+{
+  return executeAsync( [this]() { return serialPollByte(); }, IOExecutor::safety, deadline_ms, false );
+}
+
+StringView
+Messenger::fetchRaw( const std::string& msg, unsigned int timeout_ms ) const
+{
+  return execute( [&]() {
+    const unsigned int deadline_ms = timeout_ms > 0 ? timeout_ms : timeout_ms_;
+    send( msg );
+    waitForAnswer( deadline_ms );
+    //--- without completion detection, the read itself waits for the answer
+    const size_t size = receive( completion_mode_ == fixedDelay ? deadline_ms : 0 ); // may reallocate the buffer
+    return StringView( buffer_.data(), size );
+  } );
+}
+
+void
+Messenger::fetch( const std::string& msg, std::vector<StringView>& lines, unsigned int timeout_ms ) const
+{
+  execute( [&]() {
+    const StringView answer = fetchRaw( msg, timeout_ms );
+    //--- split the answer into lines, without copying
+    lines.clear();
+    size_t pos = 0;
+    while ( pos < answer.size() ) {
+      size_t end = answer.find( '\n', pos );
+      if ( end == std::string::npos )
+        end = answer.size();
+      size_t len = end-pos;
+      if ( len > 0 && answer[end-1] == '\r' )
+        --len;
+      lines.emplace_back( answer.substr( pos, len ) );
+      pos = end+1;
+    }
+  } );
+}
+
+void
+Messenger::waitForAnswer( unsigned int timeout_ms ) const
+{
+#if defined NI4882 || defined GPIB
+  switch ( completion_mode_ ) {
+    case fixedDelay:
+      std::this_thread::sleep_for( std::chrono::milliseconds( ACK_TIME_MS ) );
+      return;
+    case serialPoll: {
+      const auto deadline = std::chrono::steady_clock::now()+std::chrono::milliseconds( timeout_ms );
+      while ( !( serialPollByte() & STB_MAV ) ) {
+        if ( std::chrono::steady_clock::now() > deadline ) {
+          std::ostringstream os;
+          os << "No answer available from the device after " << timeout_ms << " ms!";
+          throw std::runtime_error( os.str() );
+        }
+        std::this_thread::sleep_for( std::chrono::microseconds( POLL_INTERVAL_US ) );
+      }
+    } return;
+    case serviceRequest: {
+      const int previous_timeout = swapTimeout( device_, timeoutCode( timeout_ms ) );
+      const int res = ibwait( device_, RQS | TIMO );
+      ibtmo( device_, previous_timeout );
+      if ( res & ( ERR | TIMO ) ) {
+        std::ostringstream os;
+        os << "No service request received from the device after " << timeout_ms << " ms!";
+        throw std::runtime_error( os.str() );
+      }
+      serialPollByte(); // acknowledge the service request
+    } return;
+  }
+#else
+  (void)timeout_ms; // no completion detection without a GPIB backend
+#endif
+}
+
+char
+Messenger::serialPollByte() const
+{
+  char status = 0;
+#if defined NI4882 || defined GPIB
+  const int res = ibrsp( device_, &status );
+  if ( res & ERR ) {
+    std::ostringstream os;
+    os
+      << "Failed to serial poll the device:\n"
+      << "Return value: " << res << ", "
+      << "GPIB error: " << gpib_error_string( ThreadIberr() );
+    throw std::runtime_error( os.str() );
+  }
+#endif
+  return status;
+}
+
+size_t
+Messenger::receive( unsigned int timeout_ms ) const
 {
 #ifdef EMULATE
-  return std::vector<std::string>{ "-1.A,1,dummy" };
+  (void)timeout_ms; // the emulated answer is always available
+  static const std::string answer = "-1.000000E-12A,+1.000000E+00,+0.000000E+00\n";
+  buffer_.assign( answer.begin(), answer.end() );
+  buffer_.emplace_back( '\0' );
+  return answer.size();
 #elif defined NI4882 || defined GPIB
   auto start = std::chrono::system_clock::now();
+  const int previous_timeout = timeout_ms > 0 ? swapTimeout( device_, timeoutCode( timeout_ms ) ) : -1;
 
-  if ( ibrd( device_, (void*)buffer_.data(), buffer_.size() ) & ERR )
-    throw std::runtime_error( "Failed to read the board buffer!" );
+  //--- read until the end of the message is signalled (EOI)
+  size_t size = 0;
+  int res = 0;
+  do {
+    if ( buffer_.size() < size+READ_CHUNK_SIZE+1 )
+      buffer_.resize( std::max( 2*buffer_.size(), size+READ_CHUNK_SIZE+1 ) );
+    res = ibrd( device_, (void*)( buffer_.data()+size ), buffer_.size()-size-1 );
+    if ( res & ERR ) {
+      if ( previous_timeout >= 0 )
+        ibtmo( device_, previous_timeout );
+      throw std::runtime_error( "Failed to read the board buffer!" );
+    }
+    size += ThreadIbcntl();
+  } while ( !( res & END ) );
+  if ( previous_timeout >= 0 )
+    ibtmo( device_, previous_timeout );
+  buffer_[size] = '\0'; // allows in-place parsing of the last value
 
   std::chrono::duration<double> dur_s = std::chrono::system_clock::now()-start;
-  LogMessage( info ) << "Transferred " << ThreadIbcntl() << " bytes in " << dur_s.count() << " seconds: "
-    << ThreadIbcntl()*1.e-3/dur_s.count() << " kb/s data throughput.";
-
-  std::vector<std::string> ret;
-  std::string tmp;
-  for ( long i = 0; i < ThreadIbcntl(); ++i ) {
-    if ( buffer_.at( i ) != '\n' )
-      tmp += buffer_.at( i );
-    else {
-      tmp += '\0'; // terminate the string
-      ret.emplace_back( tmp );
-      tmp.clear();
-    }
-  }
-  return ret;
+  static LogRateLimiter throughput_limiter( std::chrono::seconds( 1 ) );
+  IVUTILS_LOG( info, throughput_limiter ) << "Transferred " << size << " bytes in " << dur_s.count() << " seconds: "
+    << size*1.e-3/dur_s.count() << " kb/s data throughput.";
+  return size;
 #else
+  (void)timeout_ms;
   throw std::runtime_error( "No communication libraries are linked against this library! Cannot communicate..." );
 #endif
 }
@@ -1,57 +1,113 @@
 #include "ivutils/ParametersList.h"
+
 #include <sstream>
+#include <unordered_set>
+#include <mutex>
 
 using namespace ivutils;
 
+const std::string&
+ParametersList::intern( const StringView& key )
+{
+  //--- keys are shared by all lists, and never freed; as the set is node-based,
+  //    all references to its elements stay valid
+  static std::mutex mutex;
+  static std::unordered_set<std::string> keys;
+  std::lock_guard<std::mutex> lock( mutex );
+  return *keys.emplace( key.str() ).first;
+}
+
+const ParametersList::Value*
+ParametersList::find( const StringView& key, const Type& type ) const
+{
+  if ( !node_ )
+    return nullptr;
+  const auto it = node_->index.find( key );
+  if ( it == node_->index.end() )
+    return nullptr;
+  const Value& value = node_->values.at( it->second );
+  return value.type == type ? &value : nullptr;
+}
+
+ParametersList::Value&
+ParametersList::slot( const StringView& key )
+{
+  //--- copy on write; the (shallow) copy shares all non-scalar values
+  if ( !node_ )
+    node_ = std::make_shared<Node>();
+  else if ( node_.use_count() > 1 )
+    node_ = std::make_shared<Node>( *node_ );
+  auto& values = node_->values;
+  auto& index = node_->index;
+  const auto it = index.find( key );
+  if ( it != index.end() )
+    return values.at( it->second );
+  const std::string& interned = intern( key );
+  index.emplace( StringView( interned ), values.size() );
+  values.emplace_back();
+  Value& value = values.back();
+  value.key = &interned;
+  value.type = invalid;
+  value.real = 0.;
+  return value;
+}
+
 ParametersList&
 ParametersList::operator+=( const ParametersList& oth )
 {
-  param_values_.insert( oth.param_values_.begin(), oth.param_values_.end() );
-  int_values_.insert( oth.int_values_.begin(), oth.int_values_.end() );
-  dbl_values_.insert( oth.dbl_values_.begin(), oth.dbl_values_.end() );
-  str_values_.insert( oth.str_values_.begin(), oth.str_values_.end() );
-  vec_param_values_.insert( oth.vec_param_values_.begin(), oth.vec_param_values_.end() );
-  vec_int_values_.insert( oth.vec_int_values_.begin(), oth.vec_int_values_.end() );
-  vec_dbl_values_.insert( oth.vec_dbl_values_.begin(), oth.vec_dbl_values_.end() );
-  vec_str_values_.insert( oth.vec_str_values_.begin(), oth.vec_str_values_.end() );
+  if ( !oth.node_ || node_ == oth.node_ )
+    return *this;
+  if ( !node_ ) { //--- nothing to overlay; share the whole content
+    node_ = oth.node_;
+    return *this;
+  }
+  for ( const auto& value : oth.node_->values )
+    if ( node_->index.count( *value.key ) == 0 )
+      slot( *value.key ) = value; // non-scalar values are shared
   return *this;
 }
 
+ParametersList::Type
+ParametersList::type( const StringView& key ) const
+{
+  if ( !node_ )
+    return invalid;
+  const auto it = node_->index.find( key );
+  return it != node_->index.end() ? node_->values.at( it->second ).type : invalid;
+}
+
 namespace ivutils
 {
+  /// Print a comma-separated list of values
+  template<typename T> static void
+  printList( std::ostream& os, const std::vector<T>& list )
+  {
+    bool first = true;
+    for ( const auto& v : list ) {
+      os << ( first ? "" : ", " ) << v;
+      first = false;
+    }
+  }
+
   std::ostream&
   operator<<( std::ostream& os, const ParametersList& params )
   {
-    for ( const auto& kv : params.int_values_ )   os << "\n" << kv.first << ": int(" << kv.second << ")";
-    for ( const auto& kv : params.dbl_values_ )   os << "\n" << kv.first << ": double(" << kv.second << ")";
-    for ( const auto& kv : params.str_values_ )   os << "\n" << kv.first << ": string(" << kv.second << ")";
-    for ( const auto& kv : params.param_values_ ) os << "\n" << kv.first << ": param({" << kv.second << "})";
-    for ( const auto& kv : params.vec_int_values_ ) {
-      os << "\n" << kv.first << ": vint(";
-      bool first = true;
-      for ( const auto& v : kv.second ) {
-        os << ( first ? "" : ", " ) << v;
-        first = false;
-      }
-      os << ")";
-    }
-    for ( const auto& kv : params.vec_dbl_values_ ) {
-      os << "\n" << kv.first << ": vdouble(";
-      bool first = true;
-      for ( const auto& v : kv.second ) {
-        os << ( first ? "" : ", " ) << v;
-        first = false;
-      }
-      os << ")";
-    }
-    for ( const auto& kv : params.vec_str_values_ ) {
-      os << "\n" << kv.first << ": vstring(";
-      bool first = true;
-      for ( const auto& v : kv.second ) {
-        os << ( first ? "" : ", " ) << v;
-        first = false;
+    if ( !params.node_ )
+      return os;
+    for ( const auto& value : params.node_->values ) {
+      const std::string& key = *value.key;
+      os << "\n" << key << ": ";
+      switch ( value.type ) {
+        case ParametersList::integer: os << "int(" << params.getParameter<int>( key ) << ")"; break;
+        case ParametersList::real: os << "double(" << params.getParameter<double>( key ) << ")"; break;
+        case ParametersList::string: os << "string(" << params.getParameter<std::string>( key ) << ")"; break;
+        case ParametersList::params: os << "param({" << params.getParameter<ParametersList>( key ) << "})"; break;
+        case ParametersList::vec_integer: os << "vint("; printList( os, params.getParameter<std::vector<int> >( key ) ); os << ")"; break;
+        case ParametersList::vec_real: os << "vdouble("; printList( os, params.getParameter<std::vector<double> >( key ) ); os << ")"; break;
+        case ParametersList::vec_string: os << "vstring("; printList( os, params.getParameter<std::vector<std::string> >( key ) ); os << ")"; break;
+        case ParametersList::vec_params: os << "vparam("; printList( os, params.getParameter<std::vector<ParametersList> >( key ) ); os << ")"; break;
+        case ParametersList::invalid: default: os << "invalid"; break;
       }
-      os << ")";
     }
     return os;
   }
@@ -61,52 +117,28 @@ std::vector<std::string>
 ParametersList::keys() const
 {
   std::vector<std::string> out;
-  for ( const auto& p : param_values_ )     out.emplace_back( p.first );
-  for ( const auto& p : int_values_ )       out.emplace_back( p.first );
-  for ( const auto& p : dbl_values_ )       out.emplace_back( p.first );
-  for ( const auto& p : str_values_ )       out.emplace_back( p.first );
-  for ( const auto& p : vec_param_values_ ) out.emplace_back( p.first );
-  for ( const auto& p : vec_int_values_ )   out.emplace_back( p.first );
-  for ( const auto& p : vec_dbl_values_ )   out.emplace_back( p.first );
-  for ( const auto& p : vec_str_values_ )   out.emplace_back( p.first );
+  if ( !node_ )
+    return out;
+  out.reserve( node_->values.size() );
+  for ( const auto& value : node_->values )
+    out.emplace_back( *value.key );
   return out;
 }
 
 std::string
-ParametersList::getString( const std::string& key ) const
+ParametersList::getString( const StringView& key ) const
 {
   std::ostringstream os;
-  if ( hasParameter<ParametersList>( key ) )   os << "params{" << getParameter<ParametersList>( key ) << "}";
-  else if ( hasParameter<int>( key ) )         os << getParameter<int>( key );
-  else if ( hasParameter<double>( key ) )      os << getParameter<double>( key );
-  else if ( hasParameter<std::string>( key ) ) os << getParameter<std::string>( key );
-  else if ( hasParameter<std::vector<ParametersList> >( key ) ) {
-    bool first = true;
-    for ( const auto& p : getParameter<std::vector<ParametersList> >( key ) ) {
-      os << ( first ? "" : ", " ) << p;
-      first = false;
-    }
-  }
-  else if ( hasParameter<std::vector<int> >( key ) ) {
-    bool first = true;
-    for ( const auto& p : getParameter<std::vector<int> >( key ) ) {
-      os << ( first ? "" : ", " ) << p;
-      first = false;
-    }
-  }
-  else if ( hasParameter<std::vector<double> >( key ) ) {
-    bool first = true;
-    for ( const auto& p : getParameter<std::vector<double> >( key ) ) {
-      os << ( first ? "" : ", " ) << p;
-      first = false;
-    }
-  }
-  else if ( hasParameter<std::vector<std::string> >( key ) ) {
-    bool first = true;
-    for ( const auto& p : getParameter<std::vector<std::string> >( key ) ) {
-      os << ( first ? "" : ", " ) << p;
-      first = false;
-    }
+  switch ( type( key ) ) {
+    case params: os << "params{" << getParameter<ParametersList>( key ) << "}"; break;
+    case integer: os << getParameter<int>( key ); break;
+    case real: os << getParameter<double>( key ); break;
+    case string: os << getParameter<std::string>( key ); break;
+    case vec_params: printList( os, getParameter<std::vector<ParametersList> >( key ) ); break;
+    case vec_integer: printList( os, getParameter<std::vector<int> >( key ) ); break;
+    case vec_real: printList( os, getParameter<std::vector<double> >( key ) ); break;
+    case vec_string: printList( os, getParameter<std::vector<std::string> >( key ) ); break;
+    case invalid: default: break;
   }
   return os.str();
 }
@@ -116,107 +148,41 @@ ParametersList::getString( const std::string& key ) const
 //------------------------------------------------------------------
 
 template<typename T> bool
-ParametersList::hasParameter( std::string key ) const
+ParametersList::hasParameter( const StringView& key ) const
 {
-  throw std::runtime_error( "ParametersList: Invalid type for key="+key+"!" );
+  throw std::runtime_error( "ParametersList: Invalid type for key="+key.str()+"!" );
 }
 
-template<typename T> T
-ParametersList::getParameter( std::string key ) const
+template<typename T> typename ParameterRef<T>::type
+ParametersList::getParameter( const StringView& key ) const
 {
-  throw std::runtime_error( "ParametersList: Invalid type for key="+key+"!" );
+  throw std::runtime_error( "ParametersList: Invalid type for key="+key.str()+"!" );
 }
 
 template<typename T> ParametersList&
-ParametersList::set( std::string key, const T& value )
+ParametersList::set( const StringView& key, const T& value )
 {
-  throw std::runtime_error( "ParametersList: Invalid type for key="+key+"!" );
+  throw std::runtime_error( "ParametersList: Invalid type for key="+key.str()+"!" );
 }
 
 //------------------------------------------------------------------
-// sub-parameters-type attributes
-//------------------------------------------------------------------
-
-template<> ParametersList
-ParametersList::getParameter<ParametersList>( std::string key ) const
-{
-  for ( const auto& kv : param_values_ )
-    if ( kv.first.compare( key ) == 0 )
-      return kv.second;
-  throw std::runtime_error( "Failed to retrieve parameter with key="+key+"!" );
-}
-
-template<> std::vector<ParametersList>
-ParametersList::getParameter<std::vector<ParametersList> >( std::string key ) const
-{
-  for ( const auto& kv : vec_param_values_ )
-    if ( kv.first.compare( key ) == 0 )
-      return kv.second;
-  throw std::runtime_error( "Failed to retrieve parameter with key="+key+"!" );
-}
-
-//------------------------------------------------------------------
-// integer-type attributes
+// scalar attributes
 //------------------------------------------------------------------
 
 template<> int
-ParametersList::getParameter<int>( std::string key ) const
+ParametersList::getParameter<int>( const StringView& key ) const
 {
-  for ( const auto& kv : int_values_ )
-    if ( kv.first.compare( key ) == 0 )
-      return kv.second;
-  throw std::runtime_error( "Failed to retrieve parameter with key="+key+"!" );
+  const Value* value = find( key, integer );
+  if ( !value )
+    throw std::runtime_error( "Failed to retrieve parameter with key="+key.str()+"!" );
+  return value->integer;
 }
 
-template<> std::vector<int>
-ParametersList::getParameter<std::vector<int> >( std::string key ) const
-{
-  for ( const auto& kv : vec_int_values_ )
-    if ( kv.first.compare( key ) == 0 )
-      return kv.second;
-  throw std::runtime_error( "Failed to retrieve parameter with key="+key+"!" );
-}
-
-//------------------------------------------------------------------
-// floating point-type attributes
-//------------------------------------------------------------------
-
 template<> double
-ParametersList::getParameter<double>( std::string key ) const
-{
-  for ( const auto& kv : dbl_values_ )
-    if ( kv.first.compare( key ) == 0 )
-      return kv.second;
-  throw std::runtime_error( "Failed to retrieve parameter with key="+key+"!" );
-}
-
-template<> std::vector<double>
-ParametersList::getParameter<std::vector<double> >( std::string key ) const
-{
-  for ( const auto& kv : vec_dbl_values_ )
-    if ( kv.first.compare( key ) == 0 )
-      return kv.second;
-  throw std::runtime_error( "Failed to retrieve parameter with key="+key+"!" );
-}
-
-//------------------------------------------------------------------
-// string-type attributes
-//------------------------------------------------------------------
-
-template<> std::string
-ParametersList::getParameter<std::string>( std::string key ) const
-{
-  for ( const auto& kv : str_values_ )
-    if ( kv.first.compare( key ) == 0 )
-      return kv.second;
-  throw std::runtime_error( "Failed to retrieve parameter with key="+key+"!" );
-}
-
-template<> std::vector<std::string>
-ParametersList::getParameter<std::vector<std::string> >( std::string key ) const
+ParametersList::getParameter<double>( const StringView& key ) const
 {
-  for ( const auto& kv : vec_str_values_ )
-    if ( kv.first.compare( key ) == 0 )
-      return kv.second;
-  throw std::runtime_error( "Failed to retrieve parameter with key="+key+"!" );
+  const Value* value = find( key, real );
+  if ( !value )
+    throw std::runtime_error( "Failed to retrieve parameter with key="+key.str()+"!" );
+  return value->real;
 }
@@ -1,4 +1,5 @@
 #include "ivutils/PythonParser.h"
+#include "ivutils/ConfigCache.h"
 #include <frameobject.h> // Python
 
 #include <sstream>
@@ -13,6 +14,11 @@ using namespace ivutils;
 
 PythonParser::PythonParser( const char* config_file )
 {
+  //--- the interpreter is only started if the card changed since its last parsing
+  const ConfigCache cache( config_file );
+  if ( cache.load( *this ) )
+    return;
+
   setenv( "PYTHONPATH", ".:..:Cards", 1 );
   std::string filename = pythonPath( config_file );
   const size_t fn_len = filename.length()+1;
@@ -39,12 +45,47 @@ PythonParser::PythonParser( const char* config_file )
   if ( !config )
     throwPythonError( "Failed to extract a \"config\" keyword from the configuration card!" );
   ParametersList::operator+=( get<ParametersList>( config ) );
+  //--- the card itself is always tracked, whatever the interpreter reports for its module
+  auto dependencies = importedFiles();
+  if ( std::find( dependencies.begin(), dependencies.end(), config_file ) == dependencies.end() )
+    dependencies.emplace_back( config_file );
+  cache.save( *this, dependencies );
 
   //--- finalisation
   Py_CLEAR( config );
   Py_CLEAR( cfg );
 }
 
+std::vector<std::string>
+PythonParser::importedFiles() const
+{
+  //--- modules of the Python installation itself are not expected to change
+  std::vector<std::string> prefixes;
+  for ( const auto& attr : { "prefix", "exec_prefix", "base_prefix", "base_exec_prefix" } ) {
+    PyObject* pprefix = PySys_GetObject( (char*)attr ); // borrowed
+    if ( pprefix && is<std::string>( pprefix ) )
+      prefixes.emplace_back( get<std::string>( pprefix ) );
+  }
+  std::vector<std::string> out;
+  PyObject* pkey = nullptr, *pmodule = nullptr;
+  Py_ssize_t pos = 0;
+  while ( PyDict_Next( PyImport_GetModuleDict(), &pos, &pkey, &pmodule ) ) { // borrowed
+    if ( !PyObject_HasAttrString( pmodule, "__file__" ) )
+      continue; // built-in module
+    PyObject* pfile = PyObject_GetAttrString( pmodule, "__file__" ); // new
+    if ( pfile && is<std::string>( pfile ) ) {
+      std::string file = get<std::string>( pfile );
+      if ( file.size() > 4 && file.compare( file.size()-4, 4, ".pyc" ) == 0 )
+        file.pop_back(); // track the source file
+      if ( std::none_of( prefixes.begin(), prefixes.end(), [&file]( const std::string& prefix ) {
+             return !prefix.empty() && file.compare( 0, prefix.size(), prefix ) == 0; } ) )
+        out.emplace_back( file );
+    }
+    Py_CLEAR( pfile );
+  }
+  return out;
+}
+
 PythonParser::~PythonParser()
 {
   if ( Py_IsInitialized() )
@@ -0,0 +1,122 @@
+#include "ivutils/Reading.h"
+
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+using namespace ivutils;
+
+ReadingParser::ReadingParser() :
+  ReadingParser( std::vector<std::string>{ "READ", "TIME" } )
+{}
+
+ReadingParser::ReadingParser( const std::vector<std::string>& names )
+{
+  if ( names.empty() )
+    throw std::runtime_error( "ReadingParser: at least one data element is required!" );
+  for ( const auto& name : names ) {
+    if ( name == "READ" || name == "CURR" )
+      elements_.emplace_back( measurement );
+    else if ( name == "TIME" )
+      elements_.emplace_back( time );
+    else if ( name == "STAT" )
+      elements_.emplace_back( status );
+    else if ( name == "VSO" || name == "VOLT" )
+      elements_.emplace_back( sourceVoltage );
+    else
+      elements_.emplace_back( ignored );
+    elements_list_ += ( elements_list_.empty() ? "" : "," )+name;
+  }
+}
+
+void
+ReadingParser::setElement( Reading& reading, size_t index, double value ) const
+{
+  switch ( elements_[index] ) {
+    case measurement: reading.value = value; break;
+    case time: reading.timestamp = value; break;
+    case status: reading.status = value; break;
+    case sourceVoltage: reading.voltage = value; break;
+    case ignored: break;
+  }
+}
+
+namespace
+{
+  /// Parse all comma-separated numerical values of an ASCII answer, skipping their unit suffixes
+  /// \note Parsing stops as soon as the callback returns false
+  template<typename F> void
+  forEachValue( const StringView& answer, F callback )
+  {
+    const char* ptr = answer.begin(), *end = answer.end();
+    char token[64];
+    while ( ptr < end ) {
+      //--- locate the next token
+      while ( ptr < end && isspace( *ptr ) )
+        ++ptr;
+      const char* tok_end = ptr;
+      while ( tok_end < end && *tok_end != ',' && *tok_end != '\n' && *tok_end != '\r' )
+        ++tok_end;
+      const size_t tok_size = tok_end-ptr;
+      if ( tok_size == 0 && tok_end == end )
+        break;
+      if ( tok_size >= sizeof( token ) )
+        throw std::runtime_error( "Failed to parse the answer from device: "+std::string( ptr, tok_size ) );
+      //--- parse the numerical value, and skip its unit suffix
+      memcpy( token, ptr, tok_size );
+      token[tok_size] = '\0';
+      char* num_end = nullptr;
+      const double value = strtod( token, &num_end );
+      if ( num_end == token )
+        throw std::runtime_error( "Failed to parse the answer from device: "+std::string( token ) );
+      for ( ; *num_end != '\0'; ++num_end )
+        if ( !isalpha( *num_end ) && !isspace( *num_end ) )
+          throw std::runtime_error( "Failed to parse the answer from device: "+std::string( token ) );
+      if ( !callback( value ) )
+        return;
+      ptr = tok_end+1;
+    }
+  }
+}
+
+size_t
+ReadingParser::parseValues( const StringView& answer, double* values, size_t max_values )
+{
+  size_t num_values = 0;
+  if ( max_values == 0 )
+    return num_values;
+  forEachValue( answer, [&]( double value ) {
+    values[num_values++] = value;
+    return num_values < max_values;
+  } );
+  return num_values;
+}
+
+size_t
+ReadingParser::parse( const StringView& answer, std::vector<Reading>& readings ) const
+{
+  readings.clear();
+  size_t index = 0; // element index in the current reading
+  forEachValue( answer, [&]( double value ) {
+    if ( index == 0 )
+      readings.emplace_back();
+    setElement( readings.back(), index, value );
+    index = ( index+1 ) % elements_.size();
+    return true;
+  } );
+  return readings.size();
+}
+
+size_t
+ReadingParser::fill( const double* values, size_t num_values, std::vector<Reading>& readings ) const
+{
+  readings.clear();
+  for ( size_t i = 0; i < num_values; ++i ) {
+    const size_t index = i % elements_.size();
+    if ( index == 0 )
+      readings.emplace_back();
+    setElement( readings.back(), index, values[i] );
+  }
+  return readings.size();
+}
@@ -0,0 +1,131 @@
+#include "ivutils/RootOutput.h"
+#include "ivutils/Logger.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+using namespace ivutils;
+
+const std::chrono::seconds RootOutput::DEFAULT_AUTOSAVE_INTERVAL( 10 );
+const long long RootOutput::AUTOFLUSH_BYTES = 1000000;
+
+RootOutput::RootOutput( const std::string& filename, const std::vector<std::string>& stations, const std::chrono::seconds& autosave_interval ) :
+  autosave_interval_( autosave_interval ),
+  last_save_( std::chrono::steady_clock::now() ), start_( std::chrono::system_clock::now() ),
+  readings_( nullptr ), stages_( nullptr ),
+  gr_meas_( std::max<size_t>( stations.size(), 1 ) ), gr_stability_vs_time_( gr_meas_.size() ), stability_history_( gr_meas_.size() ),
+  station_( 0 ), stage_( 0 ),
+  voltage_( 0. ), time_( 0. ), timestamp_( 0. ), current_( 0. ), stdev_( 0. ),
+  status_( 0 ), num_readings_( 0 )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  file_.reset( TFile::Open( filename.c_str(), "recreate" ) );
+  if ( !file_ )
+    throw std::runtime_error( "Failed to open the output file \""+filename+"\"!" );
+  file_->cd();
+  readings_ = new TTree( "readings", "Raw ammeter readings" );
+  readings_->Branch( "station", &station_, "station/s" );
+  readings_->Branch( "stage", &stage_, "stage/s" );
+  readings_->Branch( "voltage", &voltage_, "voltage/D" );
+  readings_->Branch( "time", &time_, "time/D" );
+  readings_->Branch( "timestamp", &timestamp_, "timestamp/D" );
+  readings_->Branch( "current", &current_, "current/D" );
+  readings_->Branch( "status", &status_, "status/l" );
+  stages_ = new TTree( "stages", "Voltage stages summary" );
+  stages_->Branch( "station", &station_, "station/s" );
+  stages_->Branch( "stage", &stage_, "stage/s" );
+  stages_->Branch( "voltage", &voltage_, "voltage/D" );
+  stages_->Branch( "time", &time_, "time/D" );
+  stages_->Branch( "current", &current_, "current/D" );
+  stages_->Branch( "stdev", &stdev_, "stdev/D" );
+  stages_->Branch( "numReadings", &num_readings_, "numReadings/i" );
+  for ( size_t i = 0; i < gr_meas_.size(); ++i ) {
+    const std::string graph_prefix = ( i < stations.size() && !stations.at( i ).empty() ) ? stations.at( i )+"_" : "";
+    gr_meas_.at( i ).SetName( ( graph_prefix+"iv_scan" ).c_str() );
+    gr_meas_.at( i ).SetTitle( ";Bias (V);Leakage current (A)" );
+    gr_stability_vs_time_.at( i ).SetName( ( graph_prefix+"stability_vs_time" ).c_str() );
+    gr_stability_vs_time_.at( i ).SetTitle( ";Time (s);Leakage current (A)" );
+  }
+  //--- bound the memory used by the baskets; saves are triggered on time, not on size
+  for ( auto& tree : { readings_, stages_ } ) {
+    tree->SetAutoFlush( -AUTOFLUSH_BYTES );
+    tree->SetAutoSave( 0 );
+  }
+}
+
+RootOutput::~RootOutput()
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  file_->cd();
+  readings_->Write( nullptr, TObject::kOverwrite );
+  stages_->Write( nullptr, TObject::kOverwrite );
+  for ( auto& gr : gr_meas_ )
+    gr.Write();
+  std::vector<History::Point> points;
+  for ( size_t i = 0; i < gr_stability_vs_time_.size(); ++i ) {
+    auto& gr = gr_stability_vs_time_.at( i );
+    stability_history_.at( i ).points( points );
+    for ( const auto& pt : points )
+      gr.SetPoint( gr.GetN(), pt.x, pt.y );
+    gr.Write();
+  }
+  file_->Close();
+}
+
+void
+RootOutput::addReading( unsigned short station, unsigned short stage, double voltage, const Reading& reading )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  station_ = station;
+  stage_ = stage;
+  voltage_ = voltage;
+  time_ = std::chrono::duration<double>( std::chrono::system_clock::now()-start_ ).count();
+  timestamp_ = reading.timestamp;
+  current_ = reading.value;
+  status_ = reading.status;
+  readings_->Fill();
+  autoSave();
+}
+
+void
+RootOutput::addStage( unsigned short station, unsigned short stage, double voltage, double mean, double stdev, unsigned int num_readings )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  station_ = station;
+  stage_ = stage;
+  voltage_ = voltage;
+  time_ = std::chrono::duration<double>( std::chrono::system_clock::now()-start_ ).count();
+  current_ = mean;
+  stdev_ = stdev;
+  num_readings_ = num_readings;
+  stages_->Fill();
+  auto& gr = gr_meas_.at( station );
+  gr.SetPoint( stage, voltage, mean );
+  gr.SetPointError( stage, 0., stdev );
+  //--- a stage summary is always made persistent
+  last_save_ = std::chrono::steady_clock::time_point();
+  autoSave();
+}
+
+void
+RootOutput::addStabilityPoint( unsigned short station, double time, double current )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  stability_history_.at( station ).add( time, current );
+}
+
+void
+RootOutput::autoSave()
+{
+  const auto now = std::chrono::steady_clock::now();
+  if ( now-last_save_ < autosave_interval_ )
+    return;
+  //--- write the baskets and the trees headers, so that a crash only loses the last readings
+  readings_->AutoSave( "SaveSelf;FlushBaskets" );
+  stages_->AutoSave( "SaveSelf;FlushBaskets" );
+  last_save_ = now;
+  IVUTILS_LOG( debug ) << "Output trees saved on disk.";
+}
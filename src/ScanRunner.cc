@@ -0,0 +1,129 @@
+#include "ivutils/ScanRunner.h"
+#include "ivutils/OutputSink.h"
+#include "ivutils/Logger.h"
+#include "ivutils/JsonParser.h"
+#ifdef WITH_PYTHON
+# include "ivutils/PythonParser.h"
+#endif
+
+#include <exception>
+#include <atomic>
+#include <thread>
+
+using namespace ivutils;
+
+const std::chrono::milliseconds ScanRunner::DEFAULT_IDLE_INTERVAL( 100 );
+
+ScanRunner::ScanRunner( const char* config_file ) :
+  params_( parseCard( config_file ) ), idle_interval_( DEFAULT_IDLE_INTERVAL )
+{
+  if ( params_.hasParameter<std::string>( "logLevel" ) )
+    Logger::setLevel( Logger::level( params_.getParameter<std::string>( "logLevel" ) ) );
+  if ( params_.hasParameter<std::string>( "logFile" ) )
+    Logger::get().setOutputFile( params_.getParameter<std::string>( "logFile" ) );
+
+  if ( params_.hasParameter<std::vector<ParametersList> >( "stations" ) ) {
+    //--- multi-station setup; global parameters are used as defaults for each station
+    size_t i = 0;
+    for ( const auto& station : params_.getParameter<std::vector<ParametersList> >( "stations" ) ) {
+      ParametersList params = station;
+      params += params_;
+      const std::string name = station.hasParameter<std::string>( "name" )
+        ? station.getParameter<std::string>( "name" )
+        : "station"+std::to_string( i );
+      stations_.emplace_back( new Station( name, params ) );
+      ++i;
+    }
+  }
+  else //--- single-station setup
+    stations_.emplace_back( new Station( "", params_ ) );
+}
+
+ParametersList
+ScanRunner::parseCard( const char* config_file )
+{
+  const std::string filename( config_file );
+  if ( filename.size() > 5 && filename.compare( filename.size()-5, 5, ".json" ) == 0 )
+    return JsonParser( config_file );
+#ifdef WITH_PYTHON
+  return PythonParser( config_file ); // the interpreter is released once the card is parsed
+#else
+  throw std::runtime_error( "Python configuration cards are not supported in this build; use a JSON card instead of \""+filename+"\"." );
+#endif
+}
+
+void
+ScanRunner::setIdleCallback( const IdleCallback& callback, const std::chrono::milliseconds& interval )
+{
+  idle_callback_ = callback;
+  idle_interval_ = interval;
+}
+
+std::vector<std::string>
+ScanRunner::stationNames() const
+{
+  std::vector<std::string> out;
+  for ( const auto& station : stations_ )
+    out.emplace_back( station->name() );
+  return out;
+}
+
+void
+ScanRunner::runOnAllStations( const std::function<void( const Station&, size_t )>& operation ) const
+{
+  std::atomic<size_t> num_running( stations_.size() );
+  std::vector<std::exception_ptr> exceptions( stations_.size() );
+  std::vector<std::thread> threads;
+  for ( size_t i = 0; i < stations_.size(); ++i )
+    threads.emplace_back( [&, i]() {
+      try {
+        operation( *stations_.at( i ), i );
+      } catch ( ... ) {
+        exceptions.at( i ) = std::current_exception();
+      }
+      --num_running;
+    } );
+  //--- keep the steering thread responsive while stations are running
+  while ( true ) {
+    const bool running = ( num_running > 0 );
+    if ( idle_callback_ )
+      idle_callback_();
+    if ( !running )
+      break;
+    std::this_thread::sleep_for( idle_interval_ );
+  }
+  for ( auto& thread : threads )
+    thread.join();
+  for ( const auto& exc : exceptions )
+    if ( exc )
+      std::rethrow_exception( exc );
+}
+
+void
+ScanRunner::configure() const
+{
+  runOnAllStations( []( const Station& station, size_t ) { station.configure(); } );
+}
+
+void
+ScanRunner::rampDown() const
+{
+  runOnAllStations( []( const Station& station, size_t ) { station.rampDown(); } );
+}
+
+void
+ScanRunner::scan( OutputSink& output ) const
+{
+  runOnAllStations( [&]( const Station& station, size_t i ) {
+    station.scan( &output, i );
+  } );
+}
+
+void
+ScanRunner::test( OutputSink& output ) const
+{
+  runOnAllStations( [&]( const Station& station, size_t i ) {
+    if ( i == 0 )
+      station.test( &output, i );
+  } );
+}
@@ -0,0 +1,162 @@
+#include "ivutils/SettingsCache.h"
+
+#include <unordered_map>
+#include <cstdlib>
+#include <cctype>
+
+using namespace ivutils;
+
+namespace
+{
+  /// SCPI nodes accepted by the modules, with their short form in upper case
+  const char* const NODES[] = {
+    "ABORt", "ACQuire", "AMPLitude", "ARM", "AUTO", "AVERage", "BORDer", "CALCulate", "CLEar", "CONTrol",
+    "COUNt", "CURRent", "DATA", "DC", "DELay", "DIGits", "DISPlay", "ELEMents", "ENABle", "FEED",
+    "FILTer", "FORMat", "FUNCtion", "IMMediate", "INITiate", "LAYer", "LEVel", "LIMit", "MODE", "NPLCycles",
+    "OUTPut", "POINts", "PRESet", "PROTection", "RANGe", "RESistance", "ROUTe", "SENSe", "SEQuence", "SOURce",
+    "STATe", "STATus", "SYSTem", "TCONtrol", "TERMinals", "TRACe", "TRIGger", "TYPE", "UPPer", "VOLTage",
+    "ZCHeck", "ZCORrect"
+  };
+  /// Optional (default) nodes, omitted from the normalised header
+  const char* const OPTIONAL_ROOT_NODES[] = { "SENS" };
+  const char* const OPTIONAL_NODES[] = { "AMPL", "DC", "IMM", "LAY", "LEV", "SEQ", "STAT", "UPP" };
+
+  /// Short form of a node, from its long or short form (empty if unknown)
+  std::string
+  shortForm( const std::string& node )
+  {
+    static const std::unordered_map<std::string,std::string> forms = []() {
+      std::unordered_map<std::string,std::string> out;
+      for ( const auto& name : NODES ) {
+        std::string long_form, short_form;
+        for ( const char* c = name; *c != '\0'; ++c ) {
+          long_form += toupper( *c );
+          if ( isupper( *c ) )
+            short_form += *c;
+        }
+        out[long_form] = short_form;
+        out[short_form] = short_form;
+      }
+      return out;
+    }();
+    const auto it = forms.find( node );
+    return it != forms.end() ? it->second : std::string();
+  }
+
+  template<size_t N> bool
+  contains( const char* const ( &list )[N], const std::string& node )
+  {
+    for ( const auto& name : list )
+      if ( node == name )
+        return true;
+    return false;
+  }
+
+  StringView
+  trim( const StringView& str )
+  {
+    size_t beg = 0, end = str.size();
+    while ( beg < end && isspace( str[beg] ) )
+      ++beg;
+    while ( end > beg && isspace( str[end-1] ) )
+      --end;
+    return str.substr( beg, end-beg );
+  }
+
+  /// Parse a numerical value, if the full string represents one
+  bool
+  numericValue( const std::string& str, double& value )
+  {
+    if ( str.empty() )
+      return false;
+    char* end = nullptr;
+    value = strtod( str.c_str(), &end );
+    return end == str.c_str()+str.size();
+  }
+}
+
+std::string
+SettingsCache::header( const StringView& command )
+{
+  std::string out;
+  if ( !command.empty() && command[0] == '*' ) { // IEEE-488.2 common command
+    for ( const auto& c : command )
+      out += toupper( c );
+    return out;
+  }
+  size_t pos = ( !command.empty() && command[0] == ':' ) ? 1 : 0;
+  while ( pos < command.size() ) {
+    size_t end = command.find( ':', pos );
+    if ( end == std::string::npos )
+      end = command.size();
+    const bool root = out.empty();
+    //--- split the numerical suffix (1 being the default one)
+    std::string node;
+    for ( size_t i = pos; i < end; ++i )
+      node += toupper( command[i] );
+    pos = end+1;
+    size_t suffix_pos = node.size();
+    while ( suffix_pos > 0 && isdigit( node[suffix_pos-1] ) )
+      --suffix_pos;
+    std::string suffix = node.substr( suffix_pos );
+    if ( suffix == "1" )
+      suffix.clear();
+    const std::string name = shortForm( node.substr( 0, suffix_pos ) );
+    if ( name.empty() )
+      return std::string(); // unknown node; never cached
+    if ( suffix.empty() && ( root ? contains( OPTIONAL_ROOT_NODES, name ) : contains( OPTIONAL_NODES, name ) ) )
+      continue;
+    out += ':'+name+suffix;
+  }
+  return out;
+}
+
+void
+SettingsCache::update( const StringView& message )
+{
+  size_t pos = 0;
+  while ( pos < message.size() ) {
+    size_t end = message.find( ';', pos );
+    if ( end == std::string::npos )
+      end = message.size();
+    const StringView command = trim( message.substr( pos, end-pos ) );
+    pos = end+1;
+    const size_t space = command.find( ' ' );
+    const StringView head = command.substr( 0, space );
+    if ( head.empty() || head[head.size()-1] == '?' )
+      continue; // not a setting
+    const std::string norm_head = header( head );
+    if ( norm_head.empty() )
+      continue; // not tracked
+    if ( norm_head == "*RST" || norm_head == "*RCL" || norm_head == ":SYST:PRES" ) {
+      values_.clear(); // instrument state is not known anymore
+      continue;
+    }
+    if ( space == std::string::npos )
+      continue; // action without argument
+    values_[norm_head] = trim( command.substr( space+1 ) ).str();
+  }
+}
+
+bool
+SettingsCache::matches( const std::string& header, const std::string& value ) const
+{
+  const auto it = values_.find( header );
+  if ( it == values_.end() )
+    return false;
+  if ( it->second == value )
+    return true;
+  //--- compare numerical values independently of their formatting
+  double cached = 0., requested = 0.;
+  return numericValue( it->second, cached ) && numericValue( value, requested ) && cached == requested;
+}
+
+bool
+SettingsCache::get( const std::string& header, std::string& value ) const
+{
+  const auto it = values_.find( header );
+  if ( it == values_.end() )
+    return false;
+  value = it->second;
+  return true;
+}
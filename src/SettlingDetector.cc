@@ -0,0 +1,88 @@
+#include "ivutils/SettlingDetector.h"
+
+#include <stdexcept>
+#include <cmath>
+
+using namespace ivutils;
+
+SettlingDetector::SettlingDetector( const Model& model, double tolerance, size_t window ) :
+  model_( model ), tolerance_( tolerance ), window_( window ), estimate_( 0. )
+{
+  if ( window_ < 3 )
+    throw std::runtime_error( "Settling detection requires at least 3 samples, "+std::to_string( window_ )+" requested!" );
+}
+
+SettlingDetector::Model
+SettlingDetector::model( const std::string& name )
+{
+  if ( name == "slope" )
+    return slope;
+  if ( name == "exponential" )
+    return exponential;
+  throw std::runtime_error( "Invalid settling model: \""+name+"\". Valid models are \"slope\" and \"exponential\"." );
+}
+
+bool
+SettlingDetector::add( double time, double value )
+{
+  samples_.emplace_back( time, value );
+  if ( samples_.size() > window_ )
+    samples_.pop_front();
+  if ( samples_.size() < window_ )
+    return false;
+  switch ( model_ ) {
+    case exponential:
+      return exponentialSettled();
+    case slope: default:
+      return slopeSettled();
+  }
+}
+
+bool
+SettlingDetector::slopeSettled()
+{
+  //--- least-squares linear fit of the window
+  const double n = samples_.size();
+  double sum_t = 0., sum_v = 0.;
+  for ( const auto& s : samples_ ) {
+    sum_t += s.first;
+    sum_v += s.second;
+  }
+  const double mean_t = sum_t/n, mean_v = sum_v/n;
+  double s_tt = 0., s_tv = 0.;
+  for ( const auto& s : samples_ ) {
+    s_tt += ( s.first-mean_t )*( s.first-mean_t );
+    s_tv += ( s.first-mean_t )*( s.second-mean_v );
+  }
+  estimate_ = mean_v;
+  if ( s_tt <= 0. )
+    return false;
+  const double slope = s_tv/s_tt, offset = mean_v-slope*mean_t;
+  double s_res = 0.;
+  for ( const auto& s : samples_ ) {
+    const double res = s.second-( offset+slope*s.first );
+    s_res += res*res;
+  }
+  const double slope_unc = std::sqrt( s_res/( n-2. )/s_tt );
+  //--- drift over the window within tolerance, or not significant w.r.t. the noise
+  const double drift = std::fabs( slope )*( samples_.back().first-samples_.front().first );
+  return drift <= tolerance_*std::fabs( mean_v ) || std::fabs( slope ) <= 2.*slope_unc;
+}
+
+bool
+SettlingDetector::exponentialSettled()
+{
+  //--- average the window over three consecutive, equal-length parts
+  const size_t part = samples_.size()/3;
+  double y[3] = { 0., 0., 0. };
+  const size_t first = samples_.size()-3*part;
+  for ( size_t i = 0; i < 3*part; ++i )
+    y[i/part] += samples_[first+i].second/part;
+  //--- asymptote of an exponential through three equally-spaced points (Aitken extrapolation)
+  const double d1 = y[1]-y[0], d2 = y[2]-y[1], denom = d2-d1;
+  const double ratio = ( d1 != 0. ) ? d2/d1 : 0.;
+  if ( denom == 0. || ratio <= 0. || ratio >= 1. ) // no decaying relaxation visible
+    return slopeSettled();
+  estimate_ = y[2]-d2*d2/denom;
+  return std::fabs( y[2]-estimate_ ) <= tolerance_*std::fabs( estimate_ );
+}
@@ -0,0 +1,304 @@
+#include "ivutils/Station.h"
+#include "ivutils/ParametersList.h"
+#include "ivutils/Schema.h"
+#include "ivutils/Logger.h"
+
+#include <functional>
+#include <sstream>
+#include <cmath>
+#include <fstream>
+#include <thread>
+#include <set>
+
+using namespace ivutils;
+
+const Schema<Station::Settings>&
+Station::Settings::schema()
+{
+  static const Schema<Settings> schema = Schema<Settings>()
+    .required( "vsource", &Settings::vsource, "voltage source module parameters" )
+    .required( "ammeter", &Settings::ammeter, "ammeter module parameters" )
+    .required( "rampDown", &Settings::ramp_down, "ramp the voltage down to 0 at the end of the scan" )
+    .optional( "bufferedReadout", &Settings::buffered_readout, false, "read all currents of a voltage stage at once" )
+    .optional( "Vramp", &Settings::ramping_stages, std::vector<double>(), "voltages to ramp" )
+    .optional( "adaptiveRamp", &Settings::adaptive_ramp, ParametersList(), "adaptive voltage stages (replaces Vramp)" )
+    .required( "numRepetitions", &Settings::num_repetitions, "current values per voltage" ).range( 1 )
+    .required( "stableTime", &Settings::stable_time, "time for stabilising after changing voltage (in s)" ).range( 0 )
+    .required( "timeAtTest", &Settings::time_at_test, "time in stability test (in s)" ).range( 0 )
+    .required( "Vtest", &Settings::voltage_at_test, "voltage to test stability (abs value)" ).range( 0 )
+    .optional( "settleTolerance", &Settings::settle_tolerance, 0., "residual current drift fraction for the settling detection (0 to disable)" ).range( 0 )
+    .optional( "settleWindow", &Settings::settle_window, 5, "number of current samples considered for the settling detection" ).range( 3 )
+    .optional( "settleModel", &Settings::settle_model, std::string( "slope" ), "settling criterion ('slope' or 'exponential')" );
+  return schema;
+}
+
+/// Validate the parameters of a device block
+static Device::Settings
+deviceSettings( const ParametersList& params, const std::string& block )
+{
+  try {
+    return Device::Settings::schema().bind( params );
+  } catch ( const std::runtime_error& err ) {
+    throw std::runtime_error( "Block \""+block+"\": "+err.what() );
+  }
+}
+
+Station::Station( const std::string& name, const ParametersList& params ) :
+  Station( name, Settings::schema().bind( params ) )
+{}
+
+Station::Station( const std::string& name, const Settings& settings ) :
+  name_( name ), log_prefix_( name.empty() ? "" : "["+name+"] " ),
+  output_( nullptr ), index_( 0 ),
+  srcmeter_( deviceSettings( settings.vsource, "vsource" ) ),
+  ammeter_ ( deviceSettings( settings.ammeter, "ammeter" ) ),
+  ramp_down_      ( settings.ramp_down ),
+  buffered_readout_( settings.buffered_readout ),
+  ramping_stages_ ( settings.ramping_stages ),
+  num_repetitions_( settings.num_repetitions ),
+  stable_time_    ( settings.stable_time ),
+  time_at_test_   ( settings.time_at_test ),
+  voltage_at_test_( settings.voltage_at_test )
+{
+  IVUTILS_LOG( debug ) << log_prefix_ << "Station parameters:" << Settings::schema().dump( settings );
+  if ( settings.settle_tolerance > 0. )
+    settling_.reset( new SettlingDetector( SettlingDetector::model( settings.settle_model ), settings.settle_tolerance, settings.settle_window ) );
+  if ( !settings.adaptive_ramp.empty() )
+    adaptive_ramp_.reset( new AdaptiveRamp( settings.adaptive_ramp, { voltage_at_test_, -voltage_at_test_ } ) );
+  else if ( ramping_stages_.empty() )
+    throw std::runtime_error( log_prefix_+"Either a list of voltage stages (Vramp) or an adaptive ramp (adaptiveRamp) must be specified!" );
+#ifndef EMULATE
+  checkModules();
+#endif
+}
+
+void
+Station::checkModules() const
+{
+  { //--- check the ammeter
+    const auto& mod = ammeter_.identity();
+    if ( mod.find( "KEITHLEY" ) == std::string::npos
+      && mod.find( "MODEL 6487" ) == std::string::npos )
+      throw std::runtime_error( log_prefix_+"Expecting KEITHLEY MODEL 6487, found\n  "+mod+"\ninstead." );
+  }
+  { // --- check the sourcemeter
+    const auto& mod = srcmeter_.identity();
+    if ( mod.find( "KEITHLEY" ) == std::string::npos
+      && mod.find( "MODEL 2410" ) == std::string::npos )
+      throw std::runtime_error( log_prefix_+"Expecting KEITHLEY MODEL 2410, found\n  "+mod+"\ninstead." );
+  }
+}
+
+void
+Station::rampDown() const
+{
+  const double v_ini = std::stod( srcmeter_.setting( ":SOUR:VOLT:LEV" ) );
+  //--- first build a decreasing list of (unique) voltage values for the ramp down
+  std::set<double,std::greater<double> > vtests;
+  for ( const auto& v : adaptive_ramp_ ? adaptive_ramp_->voltages() : ramping_stages_ )
+    if ( std::fabs( v ) < std::fabs( v_ini ) )
+      vtests.insert( v );
+  if ( adaptive_ramp_ ) //--- never step down by more than the largest ramp step
+    for ( double v = v_ini; std::fabs( v ) > adaptive_ramp_->maxStep(); v -= std::copysign( adaptive_ramp_->maxStep(), v ) )
+      vtests.insert( v-std::copysign( adaptive_ramp_->maxStep(), v ) );
+  vtests.insert( 0. ); // ensure we finish there...
+  {
+    std::ostringstream os;
+    for ( const auto& v : vtests )
+      os << " " << v;
+    IVUTILS_LOG( info ) << log_prefix_ << "RAMPDOWN: will use the following values:"
+      << os.str() << " V.";
+  }
+  for ( const auto& v : vtests ) {
+    //--- set the voltage
+    srcmeter_.set( ":SOUR:VOLT:LEV", v );
+    settle();
+    IVUTILS_LOG( info ) << log_prefix_ << "RAMPDOWN: currently at " << v << " V.";
+  }
+  IVUTILS_LOG( info ) << log_prefix_ << "RAMPDOWN: finished!";
+}
+
+void
+Station::scan( OutputSink* output, unsigned short index ) const
+{
+  output_ = output;
+  index_ = index;
+
+  if ( adaptive_ramp_ ) {
+    adaptive_ramp_->reset();
+    if ( adaptive_ramp_->compliance() <= 0. ) //--- stop before the source meter compliance limit
+      adaptive_ramp_->setCompliance( strtod( srcmeter_.setting( ":SENS:CURR:PROT" ).c_str(), nullptr ) );
+  }
+
+  //--- buffer transfer of the previous stage, overlapped with the next set-point
+  std::future<std::vector<Reading> > pending_readings;
+  size_t pending_stage = 0;
+  double pending_voltage = 0.;
+  double vr = 0.;
+  for ( size_t i = 0; ; ++i ) {
+    //--- an adaptive stage depends on the readings of the previous one
+    if ( adaptive_ramp_ && pending_readings.valid() )
+      recordStage( pending_stage, pending_voltage, addReadings( pending_stage, pending_voltage, pending_readings.get() ) );
+    if ( !nextStage( i, vr ) )
+      break;
+    IVUTILS_LOG( info ) << log_prefix_ << "RAMPING: currently at " << vr << " V.";
+    //--- set the voltage
+    std::future<bool> voltage_set = srcmeter_.setAsync( ":SOUR:VOLT:LEV", vr );
+    //--- meanwhile, process the readings of the previous stage
+    if ( pending_readings.valid() )
+      recordStage( pending_stage, pending_voltage, addReadings( pending_stage, pending_voltage, pending_readings.get() ) );
+    voltage_set.get();
+
+    //--- output values while ramping and at stabilisation time
+    RunningStatistics i_ramp;
+    if ( std::fabs( vr ) == voltage_at_test_ ) //--- measure currents at test voltage
+      stabilityTest( i, vr, i_ramp );
+    else { //--- measure currents while ramping voltage
+      settle();
+      if ( buffered_readout_ ) { //--- read all current values at once, while moving to the next stage
+        ammeter_.acquireBuffer( num_repetitions_ );
+        pending_readings = ammeter_.fetchBufferAsync( num_repetitions_ );
+        pending_stage = i;
+        pending_voltage = vr;
+        continue;
+      }
+      for ( unsigned short j = 0; j < num_repetitions_; ++j ) {
+        //--- read current value
+        const auto& val_at_time = ammeter_.readValue( Device::M_READ, "A" );
+        i_ramp.add( val_at_time.value );
+        if ( output_ )
+          output_->addReading( index_, i, vr, val_at_time );
+      }
+    }
+    recordStage( i, vr, i_ramp );
+  }
+  if ( pending_readings.valid() )
+    recordStage( pending_stage, pending_voltage, addReadings( pending_stage, pending_voltage, pending_readings.get() ) );
+
+  if ( ramp_down_ )
+    rampDown();
+}
+
+void
+Station::settle() const
+{
+  if ( !settling_ ) {
+    std::this_thread::sleep_for( std::chrono::seconds( stable_time_ ) );
+    return;
+  }
+  settling_->reset();
+  const auto start = std::chrono::steady_clock::now();
+  while ( true ) {
+    const double elapsed_sec = std::chrono::duration<double>( std::chrono::steady_clock::now()-start ).count();
+    if ( elapsed_sec >= stable_time_ ) {
+      IVUTILS_LOG( debug ) << log_prefix_ << "Current not settled after " << stable_time_ << " s.";
+      return;
+    }
+    const auto& val_at_time = ammeter_.readValue( Device::M_READ, "A" );
+    if ( settling_->add( elapsed_sec, val_at_time.value ) ) {
+      IVUTILS_LOG( debug ) << log_prefix_ << "Current settled after " << elapsed_sec << " s, "
+        << "at " << settling_->estimate() << " A.";
+      return;
+    }
+  }
+}
+
+RunningStatistics
+Station::addReadings( size_t i, double vr, const std::vector<Reading>& readings ) const
+{
+  RunningStatistics out;
+  for ( const auto& val_at_time : readings ) {
+    out.add( val_at_time.value );
+    if ( output_ )
+      output_->addReading( index_, i, vr, val_at_time );
+  }
+  return out;
+}
+
+bool
+Station::nextStage( size_t i, double& voltage ) const
+{
+  if ( adaptive_ramp_ )
+    return adaptive_ramp_->next( voltage );
+  if ( i >= ramping_stages_.size() )
+    return false;
+  voltage = ramping_stages_.at( i );
+  return true;
+}
+
+void
+Station::recordStage( size_t i, double vr, const RunningStatistics& currents ) const
+{
+  const double mean_i = currents.mean(), stdev_i = currents.stdev();
+  if ( adaptive_ramp_ )
+    adaptive_ramp_->add( vr, mean_i );
+  if ( output_ )
+    output_->addStage( index_, i, vr, mean_i, stdev_i, currents.count() );
+  IVUTILS_LOG( info ) << log_prefix_
+    << "Measurement " << i+1 << "/" << numStages() << ": "
+    << vr << " V, "
+    << "Current = " << mean_i << " +- " << stdev_i << " A.";
+}
+
+void
+Station::stabilityTest( size_t i, double vr, RunningStatistics& i_ramp ) const
+{
+  IVUTILS_LOG( info ) << log_prefix_ << "Stability test ongoing, please wait:";
+  //--- summary of the currents at stabilisation time, in constant memory
+  RunningStatistics i_stable;
+  RunningMedian i_stable_median;
+  size_t n = 0;
+  auto start = std::chrono::system_clock::now();
+
+  double elapsed_sec = 0.;
+  while ( elapsed_sec < time_at_test_ ) {
+    //--- necessary wait between two measurements of current value
+    //    (only the first one follows the voltage step)
+    if ( n == 0 )
+      settle();
+    else
+      std::this_thread::sleep_for( std::chrono::seconds( stable_time_ ) );
+    const auto& val_at_time = ammeter_.readValue( Device::M_READ, "A" );
+    if ( output_ )
+      output_->addReading( index_, i, vr, val_at_time );
+    if ( n++ < num_repetitions_ )
+      i_ramp.add( val_at_time.value );
+    else {
+      i_stable.add( val_at_time.value );
+      i_stable_median.add( val_at_time.value );
+      if ( output_ )
+        output_->addStabilityPoint( index_, elapsed_sec, val_at_time.value );
+    }
+    elapsed_sec = std::chrono::duration_cast<std::chrono::seconds>( std::chrono::system_clock::now()-start ).count();
+  }
+  IVUTILS_LOG( info ) << log_prefix_ << "Stability test finished! "
+    << "Current = " << i_stable.mean() << " +- " << i_stable.stdev() << " A "
+    << "(median: " << i_stable_median.median() << " A, MAD: " << i_stable_median.mad() << " A, "
+    << "range: [" << i_stable.min() << ", " << i_stable.max() << "] A, "
+    << i_stable.count() << " measurements).";
+}
+
+void
+Station::test( OutputSink* output, unsigned short index ) const
+{
+  //--- prepare outputs
+  std::ofstream out_file( "test.out" );
+
+  //--- launch the acquisition
+  ammeter_.set( ":SOUR:VOLT:LEV", 1. );
+  for ( unsigned short i = 0; i < 1000; ++i ) {
+    const auto& val = ammeter_.readValue();
+    out_file << val.timestamp << "\t" << val.value << std::endl;
+    if ( output )
+      output->addReading( index, 0, 1., val );
+  }
+  ammeter_.set( ":SOUR:VOLT:LEV", 0. );
+  out_file.close();
+}
+
+void
+Station::configure() const
+{
+  ammeter_.initialise();
+  srcmeter_.initialise();
+}
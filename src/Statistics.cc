@@ -0,0 +1,155 @@
+#include "ivutils/Statistics.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace ivutils;
+
+//--- running mean, variance, and extrema
+
+void
+RunningStatistics::add( const double* values, size_t num_values )
+{
+  if ( num_values == 0 )
+    return;
+  //--- independent partial sums, to let the compiler vectorise both passes
+  double sum[4] = { 0., 0., 0., 0. };
+  double lo[4] = { values[0], values[0], values[0], values[0] }, hi[4] = { values[0], values[0], values[0], values[0] };
+  size_t i = 0;
+  for ( ; i+4 <= num_values; i += 4 )
+    for ( size_t j = 0; j < 4; ++j ) {
+      sum[j] += values[i+j];
+      lo[j] = std::min( lo[j], values[i+j] );
+      hi[j] = std::max( hi[j], values[i+j] );
+    }
+  for ( ; i < num_values; ++i ) {
+    sum[0] += values[i];
+    lo[0] = std::min( lo[0], values[i] );
+    hi[0] = std::max( hi[0], values[i] );
+  }
+  RunningStatistics batch;
+  batch.count_ = num_values;
+  batch.mean_ = ( sum[0]+sum[1]+sum[2]+sum[3] )/num_values;
+  batch.min_ = std::min( std::min( lo[0], lo[1] ), std::min( lo[2], lo[3] ) );
+  batch.max_ = std::max( std::max( hi[0], hi[1] ), std::max( hi[2], hi[3] ) );
+  //--- second pass on the (cached) batch, numerically stable
+  double m2[4] = { 0., 0., 0., 0. };
+  for ( i = 0; i+4 <= num_values; i += 4 )
+    for ( size_t j = 0; j < 4; ++j ) {
+      const double delta = values[i+j]-batch.mean_;
+      m2[j] += delta*delta;
+    }
+  for ( ; i < num_values; ++i ) {
+    const double delta = values[i]-batch.mean_;
+    m2[0] += delta*delta;
+  }
+  batch.m2_ = m2[0]+m2[1]+m2[2]+m2[3];
+  merge( batch );
+}
+
+void
+RunningStatistics::merge( const RunningStatistics& oth )
+{
+  if ( oth.count_ == 0 )
+    return;
+  if ( count_ == 0 ) {
+    *this = oth;
+    return;
+  }
+  const size_t count = count_+oth.count_;
+  const double delta = oth.mean_-mean_;
+  mean_ += delta*oth.count_/count;
+  m2_ += oth.m2_+delta*delta*count_*oth.count_/count;
+  count_ = count;
+  min_ = std::min( min_, oth.min_ );
+  max_ = std::max( max_, oth.max_ );
+}
+
+//--- P-square quantile estimator
+
+P2Quantile::P2Quantile( double quantile ) :
+  quantile_( quantile )
+{
+  if ( quantile <= 0. || quantile >= 1. )
+    throw std::runtime_error( "Invalid quantile probability: "+std::to_string( quantile )+"!" );
+  clear();
+}
+
+void
+P2Quantile::clear()
+{
+  count_ = 0;
+  const double p = quantile_;
+  const double desired[5] = { 1., 1.+2.*p, 1.+4.*p, 3.+2.*p, 5. };
+  const double increments[5] = { 0., 0.5*p, p, 0.5*( 1.+p ), 1. };
+  for ( int i = 0; i < 5; ++i ) {
+    heights_[i] = 0.;
+    positions_[i] = i+1.;
+    desired_[i] = desired[i];
+    increments_[i] = increments[i];
+  }
+}
+
+void
+P2Quantile::add( double value )
+{
+  //--- first values are stored (sorted) as the initial markers
+  if ( count_ < 5 ) {
+    heights_[count_++] = value;
+    std::sort( heights_, heights_+count_ );
+    return;
+  }
+  ++count_;
+  //--- find the cell holding the value, and adjust the extreme markers
+  int k = 0;
+  if ( value < heights_[0] ) {
+    heights_[0] = value;
+    k = 0;
+  }
+  else if ( value >= heights_[4] ) {
+    heights_[4] = value;
+    k = 3;
+  }
+  else
+    while ( k < 3 && value >= heights_[k+1] )
+      ++k;
+  for ( int i = k+1; i < 5; ++i )
+    positions_[i] += 1.;
+  for ( int i = 0; i < 5; ++i )
+    desired_[i] += increments_[i];
+  //--- adjust the central markers heights if they drifted from their desired positions
+  for ( int i = 1; i < 4; ++i ) {
+    const double d = desired_[i]-positions_[i];
+    if ( ( d >= 1. && positions_[i+1]-positions_[i] > 1. )
+      || ( d <= -1. && positions_[i-1]-positions_[i] < -1. ) ) {
+      const int sign = d >= 0. ? 1 : -1;
+      const double height = parabolic( i, sign );
+      heights_[i] = ( heights_[i-1] < height && height < heights_[i+1] ) ? height : linear( i, sign );
+      positions_[i] += sign;
+    }
+  }
+}
+
+double
+P2Quantile::value() const
+{
+  if ( count_ == 0 )
+    return 0.;
+  if ( count_ <= 5 ) // exact quantile of the stored values
+    return heights_[std::min<size_t>( count_-1, (size_t)std::floor( quantile_*count_ ) )];
+  return heights_[2];
+}
+
+double
+P2Quantile::parabolic( int i, int d ) const
+{
+  return heights_[i]+d/( positions_[i+1]-positions_[i-1] )*(
+    ( positions_[i]-positions_[i-1]+d )*( heights_[i+1]-heights_[i] )/( positions_[i+1]-positions_[i] )
+   +( positions_[i+1]-positions_[i]-d )*( heights_[i]-heights_[i-1] )/( positions_[i]-positions_[i-1] ) );
+}
+
+double
+P2Quantile::linear( int i, int d ) const
+{
+  return heights_[i]+d*( heights_[i+d]-heights_[i] )/( positions_[i+d]-positions_[i] );
+}
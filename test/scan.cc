@@ -3,8 +3,10 @@
 
 int main( int argc, char* argv[] )
 {
-  if ( argc < 2 )
-    ivutils::LogMessage( ivutils::error ) << "Usage: " << argv[0] << " config_file";
+  if ( argc < 2 ) {
+    IVUTILS_LOG( ivutils::error ) << "Usage: " << argv[0] << " config_file";
+    return -1;
+  }
 
   ivutils::IVScanner scanner( argv[1] );
   scanner.configure();
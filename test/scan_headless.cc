@@ -0,0 +1,18 @@
+#include "ivutils/ScanRunner.h"
+#include "ivutils/CsvOutput.h"
+#include "ivutils/Logger.h"
+
+int main( int argc, char* argv[] )
+{
+  if ( argc < 2 ) {
+    IVUTILS_LOG( ivutils::error ) << "Usage: " << argv[0] << " config_file [output_prefix]";
+    return -1;
+  }
+
+  ivutils::ScanRunner runner( argv[1] );
+  ivutils::CsvOutput output( ( argc > 2 ) ? argv[2] : "output_ivscan" );
+  runner.configure();
+  runner.scan( output );
+
+  return 0;
+}
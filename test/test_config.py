@@ -1,6 +1,12 @@
 config = dict(
     ammeter = dict(
         address = 22,
+        #board = 0, # index of the GPIB interface board the module is connected to
+        #completionMode = 'poll', # how the end of a query is detected ('delay', 'poll', or 'srq'; default: delay)
+        queryTimeout = 3000, # deadline for an answer to be available (in ms)
+        bufferTimeout = 30000, # deadline for a buffered acquisition to complete (in ms)
+        #dataFormat = 'real32', # numerical values transfer format ('ascii', 'real32', or 'real64'; default: ascii)
+        dataElements = ('READ', 'TIME', 'STAT'), # elements transmitted for each reading
         configCommands = (
             'SYST:ZCOR OFF',
             #'RANG 2e-9',
@@ -17,6 +23,10 @@ config = dict(
     ),
     vsource = dict(
         address = 24,
+        #inputBufferSize = 256, # maximal length of a single (joined) message sent to the module
+        #warmAttach = True, # skip the reset and configuration if the module state is unchanged since the last session
+        #stateFile = '.ivutils_state_0_24', # file holding the module fingerprint (default: .ivutils_state_<board>_<address>)
+        #stateQuery = ':ROUT:TERM?', # cheap query reading back a configured setting, changed by a reset or a power cycle (required for warmAttach); must not be altered by the closing commands
         configCommands = (
             ':ROUT:TERM REAR',              # switch output terminals to rear panel
             ':SOUR:FUNC VOLT',              # select voltage source function
@@ -34,13 +44,35 @@ config = dict(
             ':OUTP OFF',
         ),
     ),
+    # multi-station setup: stations are scanned concurrently, each with its own voltage
+    # source and ammeter (e.g. on its own GPIB board); all other parameters are used as
+    # defaults, and may be overridden in each station block
+    #stations = [
+    #    dict(name = 'left', vsource = dict(address = 24, board = 0, ...), ammeter = dict(address = 22, board = 0, ...)),
+    #    dict(name = 'right', vsource = dict(address = 24, board = 1, ...), ammeter = dict(address = 22, board = 1, ...)),
+    #],
     #Vramp = range(0, 1050, 50), # Voltages to ramp (start, highest (+1 step), step)
     #Vtest = 1000., # Voltage to test stability (abs value)
+    # adaptive ramp (replaces Vramp): coarse steps, refined where the current rises or bends quickly
+    #adaptiveRamp = dict(
+    #    start = 0., stop = 1000., # voltage range (in V)
+    #    maxPoints = 30, # total number of voltage stages
+    #    maxStep = 50., minStep = 5., # voltage step limits (in V)
+    #    riseThreshold = 0.5, # maximal relative current increase over a maximal step
+    #    curvatureThreshold = 0.5, # maximal change of the logarithmic I-V slope over a maximal step
+    #    compliance = 1.e-6, # current at which the ramp is stopped (default: source meter compliance limit)
+    #),
     #stableTime = 50, # time for stabilizing after changing voltage (in seconds)
     timeAtTest = 10*60, # timein stability test at voltage Vtest (in seconds)
     numRepetitions = 10, # current values per voltage
+    #settleTolerance = 0.01, # stop waiting for stabilization once the residual current drift is below this fraction (stableTime is an upper bound)
+    #settleWindow = 5, # number of current samples considered for the settling detection
+    #settleModel = 'slope', # settling criterion ('slope' for a drift below tolerance, or 'exponential' for an RC relaxation extrapolation)
+    bufferedReadout = False, # acquire all current values per voltage in the ammeter buffer, and read them at once
     bothPolarities = False,
     rampDown = False,
+    logLevel = 'info', # most verbose log messages to be emitted ('error', 'warning', 'info', or 'debug')
+    #logFile = 'ivscan.log', # also write all log messages into this file
     # my testing
     Vramp = [n*0.1 for n in range(0, 10, 1)], # Voltages to ramp (start, highest (+1 step), step)
     Vtest = 1., # Voltage to test stability (abs value)
@@ -0,0 +1,162 @@
+#include "ivutils/ConfigCache.h"
+#include "ivutils/Logger.h"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <cstdio>
+
+using namespace ivutils;
+
+namespace
+{
+  unsigned short num_failures = 0;
+
+  void
+  check( bool condition, const std::string& what )
+  {
+    if ( condition )
+      return;
+    IVUTILS_LOG( error ) << "Check failed: " << what << ".";
+    ++num_failures;
+  }
+
+  void
+  writeFile( const std::string& path, const std::string& content )
+  {
+    std::ofstream file( path, std::ios::binary | std::ios::trunc );
+    file.write( content.data(), content.size() );
+  }
+
+  std::string
+  readFile( const std::string& path )
+  {
+    std::ifstream file( path, std::ios::binary );
+    return std::string( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+  }
+
+  std::string
+  serialised( const ParametersList& params )
+  {
+    std::string out;
+    ConfigCache::serialise( params, out );
+    return out;
+  }
+
+  /// Configuration holding all parameter types, at several nesting levels
+  ParametersList
+  sampleConfiguration()
+  {
+    ParametersList sub;
+    sub.set<std::string>( "name", "ammeter" );
+    sub.set<std::vector<std::string> >( "commands", { "SYST:ZCOR OFF", "", "CURR:RANG 2e-9" } );
+    ParametersList station;
+    station.set<int>( "id", 1 );
+    station.set<ParametersList>( "ammeter", sub );
+    ParametersList params;
+    params.set<int>( "address", -22 );
+    params.set<double>( "maxVoltage", -1.2345678901234567e3 );
+    params.set<std::string>( "output", "" );
+    params.set<std::vector<int> >( "elements", { 1, -2, 2147483647 } );
+    params.set<std::vector<double> >( "ramp", { 0., 0.5, -1.e-12 } );
+    params.set<std::vector<ParametersList> >( "stations", { station, station } );
+    params.set<ParametersList>( "ammeter", sub );
+    return params;
+  }
+}
+
+int main()
+{
+  const ParametersList params = sampleConfiguration();
+  const std::string data = serialised( params );
+
+  //--- in-memory round trip
+  {
+    StringView view( data );
+    const ParametersList decoded = ConfigCache::deserialise( view );
+    check( view.empty(), "whole representation consumed" );
+    check( serialised( decoded ) == data, "round trip preserves the representation" );
+    check( decoded.getParameter<double>( "maxVoltage" ) == params.getParameter<double>( "maxVoltage" ), "floating point value preserved" );
+    check( decoded.getParameter<std::vector<ParametersList> >( "stations" ).at( 1 )
+      .getParameter<ParametersList>( "ammeter" ).getParameter<std::vector<std::string> >( "commands" ).at( 2 ) == "CURR:RANG 2e-9",
+      "nested values preserved" );
+  }
+  //--- truncated representations are all rejected
+  {
+    unsigned short num_accepted = 0;
+    for ( size_t size = 0; size < data.size(); ++size ) {
+      StringView view( data.data(), size );
+      try {
+        ConfigCache::deserialise( view );
+        ++num_accepted;
+      } catch ( const std::runtime_error& ) {}
+    }
+    check( num_accepted == 0, "truncated representations rejected" );
+  }
+  //--- corrupted representations never crash, and invalid types are rejected
+  {
+    for ( size_t i = 0; i < data.size(); ++i )
+      for ( unsigned char flip : { 0x01, 0x80, 0xff } ) {
+        std::string corrupted = data;
+        corrupted[i] ^= flip;
+        StringView view( corrupted );
+        try {
+          ConfigCache::deserialise( view );
+        } catch ( const std::runtime_error& ) {}
+      }
+    std::string corrupted = data;
+    corrupted[data.find( "address" )+7] = 0x7f; // type of the "address" parameter
+    StringView view( corrupted );
+    bool rejected = false;
+    try {
+      ConfigCache::deserialise( view );
+    } catch ( const std::runtime_error& ) {
+      rejected = true;
+    }
+    check( rejected, "invalid parameter type rejected" );
+  }
+
+  //--- cache file round trip
+  const std::string card = "test_config_cache_card.py", module = "test_config_cache_module.py";
+  writeFile( card, "config = dict( address = -22 )\n" );
+  writeFile( module, "" ); // empty dependencies are valid
+  const ConfigCache cache( card );
+  std::remove( cache.path().c_str() );
+  ParametersList loaded;
+  check( !cache.load( loaded ), "missing cache not loaded" );
+  cache.save( params, { card, module } );
+  check( cache.load( loaded ) && serialised( loaded ) == data, "configuration loaded from cache" );
+
+  //--- truncated or corrupted cache files
+  const std::string cache_content = readFile( cache.path() );
+  writeFile( cache.path(), cache_content.substr( 0, cache_content.size()-1 ) );
+  check( !cache.load( loaded ), "truncated cache not loaded" );
+  writeFile( cache.path(), cache_content.substr( 0, 6 ) );
+  check( !cache.load( loaded ), "truncated cache header not loaded" );
+  writeFile( cache.path(), "" );
+  check( !cache.load( loaded ), "empty cache not loaded" );
+  writeFile( cache.path(), "XXXX"+cache_content.substr( 4 ) );
+  check( !cache.load( loaded ), "cache with an invalid magic number not loaded" );
+  writeFile( cache.path(), cache_content );
+  check( cache.load( loaded ), "restored cache loaded" );
+
+  //--- a changed or missing dependency invalidates the cache
+  writeFile( module, "voltage = 1\n" );
+  check( !cache.load( loaded ), "cache invalidated by a changed dependency" );
+  writeFile( module, "" );
+  check( cache.load( loaded ), "cache valid again with the original dependency" );
+  std::remove( module.c_str() );
+  check( !cache.load( loaded ), "cache invalidated by a missing dependency" );
+  cache.save( params, { card, module } );
+  check( !cache.load( loaded ), "configuration with a missing dependency not cached" );
+
+  std::remove( card.c_str() );
+  std::remove( cache.path().c_str() );
+
+  if ( num_failures > 0 ) {
+    IVUTILS_LOG( error ) << num_failures << " check(s) failed!";
+    return -1;
+  }
+  IVUTILS_LOG( info ) << "All checks passed.";
+  return 0;
+}
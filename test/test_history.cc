@@ -0,0 +1,110 @@
+#include "ivutils/History.h"
+#include "ivutils/Logger.h"
+
+#include <random>
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+
+using namespace ivutils;
+
+namespace
+{
+  unsigned short num_failures = 0;
+
+  void
+  check( bool condition, const std::string& what )
+  {
+    if ( condition )
+      return;
+    IVUTILS_LOG( error ) << "Check failed: " << what << ".";
+    ++num_failures;
+  }
+
+  bool
+  ordered( const std::vector<History::Point>& points )
+  {
+    for ( size_t i = 1; i < points.size(); ++i )
+      if ( points.at( i ).x < points.at( i-1 ).x )
+        return false;
+    return true;
+  }
+
+  bool
+  contains( const std::vector<History::Point>& points, double y )
+  {
+    return std::any_of( points.begin(), points.end(), [&y]( const History::Point& p ) { return p.y == y; } );
+  }
+}
+
+int main()
+{
+  std::mt19937 gen( 42 );
+  std::normal_distribution<double> noise( 0., 1.e-11 );
+
+  //--- bounded memory for an arbitrarily long series
+  {
+    const size_t raw_capacity = 100, num_buckets = 50;
+    History history( raw_capacity, num_buckets );
+    std::vector<History::Point> points;
+    double y_min = 0., y_max = 0.;
+    size_t max_buckets = 0, max_points = 0;
+    bool consistent = true;
+    for ( size_t i = 0; i < 1000000; ++i ) {
+      const double y = -1.e-9+noise( gen )+( i == 123456 ? 1.e-6 : 0. )+( i == 654321 ? -1.e-6 : 0. );
+      y_min = std::min( y_min, y );
+      y_max = std::max( y_max, y );
+      history.add( i*0.1, y );
+      max_buckets = std::max( max_buckets, history.buckets().size() );
+      if ( i % 9973 == 0 || i < 1000 ) {
+        history.points( points );
+        max_points = std::max( max_points, points.size() );
+        size_t count = std::min( raw_capacity, history.count() );
+        for ( const auto& bucket : history.buckets() )
+          count += bucket.count;
+        consistent = consistent && count == history.count() && ordered( points );
+      }
+    }
+    check( history.count() == 1000000, "number of points" );
+    check( max_buckets <= num_buckets, "number of buckets bounded" );
+    check( max_points <= 2*num_buckets+raw_capacity, "multi-resolution view size bounded" );
+    check( consistent, "all points summarised, in chronological order" );
+    history.points( points );
+    check( contains( points, y_max ) && contains( points, y_min ), "spikes preserved in the summaries" );
+    history.clear();
+    history.points( points );
+    check( history.count() == 0 && points.empty(), "cleared history" );
+  }
+
+  //--- largest-triangle-three-buckets decimation
+  {
+    std::normal_distribution<double> jitter( 0., 1.e-2 );
+    std::vector<History::Point> series;
+    for ( size_t i = 0; i < 10000; ++i )
+      series.emplace_back( History::Point{ i*1., std::sin( i*1.e-3 )+jitter( gen )+( i == 4321 ? 10. : 0. ) } );
+    std::vector<History::Point> out;
+    for ( size_t threshold : { 3, 4, 100, 999, 9999 } ) {
+      History::decimate( series, threshold, out );
+      std::ostringstream os;
+      os << " (threshold " << threshold << ")";
+      check( out.size() == threshold, "output size"+os.str() );
+      check( out.front().x == series.front().x && out.back().x == series.back().x, "first and last points kept"+os.str() );
+      check( ordered( out ), "output ordered"+os.str() );
+      if ( threshold >= 100 )
+        check( contains( out, series.at( 4321 ).y ), "spike kept"+os.str() );
+    }
+    for ( size_t threshold : { 0, 2, 10000, 20000 } ) {
+      History::decimate( series, threshold, out );
+      check( out.size() == series.size(), "series kept as is for threshold "+std::to_string( threshold ) );
+    }
+    History::decimate( std::vector<History::Point>(), 100, out );
+    check( out.empty(), "empty series" );
+  }
+
+  if ( num_failures > 0 ) {
+    IVUTILS_LOG( error ) << num_failures << " check(s) failed!";
+    return -1;
+  }
+  IVUTILS_LOG( info ) << "All checks passed.";
+  return 0;
+}
@@ -2,21 +2,25 @@
 #include "ivutils/Device.h"
 #include "ivutils/Logger.h"
 
+using namespace ivutils;
+
 int main( int argc, char* argv[] )
 {
-  if ( argc < 2 )
-    LogMessage( error ) << "Usage: " << argv[0] << " device_address [secondary_address]";
+  if ( argc < 2 ) {
+    IVUTILS_LOG( error ) << "Usage: " << argv[0] << " device_address [secondary_address]";
+    return -1;
+  }
 
   const int dev_addr = atoi( argv[1] );
   const int sec_addr = ( argc > 2 ) ? atoi( argv[2] ) : 0;
 
-  LogMessage( info ) << "Will fetch device address: " << dev_addr << "|" << sec_addr << ".";
+  IVUTILS_LOG( info ) << "Will fetch device address: " << dev_addr << "|" << sec_addr << ".";
 
   ivutils::Messenger mess( dev_addr, sec_addr );
   for ( const auto& answ : mess.fetch( ivutils::Device::M_DEVICE_ID ) )
-    LogMessage( info ) << "Device ID: " << answ;
+    IVUTILS_LOG( info ) << "Device ID: " << answ;
   for ( const auto& answ : mess.fetch( ivutils::Device::M_READ/*":READ?"*/ ) )
-    LogMessage( info ) << "Read value: " << answ;
+    IVUTILS_LOG( info ) << "Read value: " << answ;
 
   return 0;
 }
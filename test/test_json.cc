@@ -0,0 +1,112 @@
+#include "ivutils/JsonParser.h"
+#include "ivutils/Logger.h"
+
+#include <stdexcept>
+
+using namespace ivutils;
+
+namespace
+{
+  unsigned short num_failures = 0;
+
+  void
+  check( bool condition, const std::string& what )
+  {
+    if ( condition )
+      return;
+    IVUTILS_LOG( error ) << "Check failed: " << what << ".";
+    ++num_failures;
+  }
+
+  /// Check that a parsing failure is reported, with the expected message and position
+  template<typename F> void
+  checkThrows( F parse, const std::string& expected, const std::string& what )
+  {
+    try {
+      parse();
+      check( false, what+" (no exception)" );
+    } catch ( const std::runtime_error& err ) {
+      check( std::string( err.what() ).find( expected ) != std::string::npos,
+        what+" (got \""+err.what()+"\", expecting \""+expected+"\")" );
+    }
+  }
+}
+
+int main()
+{
+  //--- value types and promotions
+  {
+    const ParametersList params = JsonParser::parse(
+      "{ \"int\": 42, \"neg\": -3, \"real\": 1.5, \"exp\": 1e3, \"yes\": true, \"no\": false,"
+      "  \"ints\": [1, 2, 3], \"mixed\": [1, 2.5, -3], \"strs\": [\"a\", \"b\"], \"objs\": [{ \"x\": 1 }, { \"x\": 2 }],"
+      "  \"sub\": { \"name\": \"sub\" }, \"none\": null, \"empty\": [] }" );
+    check( params.hasParameter<int>( "int" ) && params.getParameter<int>( "int" ) == 42, "integer value" );
+    check( params.hasParameter<int>( "neg" ) && params.getParameter<int>( "neg" ) == -3, "negative integer value" );
+    check( params.hasParameter<double>( "real" ) && params.getParameter<double>( "real" ) == 1.5, "floating point value" );
+    check( params.hasParameter<double>( "exp" ) && params.getParameter<double>( "exp" ) == 1.e3, "exponent promoted to double" );
+    check( params.getParameter<bool>( "yes" ) && !params.getParameter<bool>( "no" ), "booleans mapped to int" );
+    check( params.hasParameter<std::vector<int> >( "ints" )
+      && params.getParameter<std::vector<int> >( "ints" ) == std::vector<int>{ 1, 2, 3 }, "integers array" );
+    check( params.hasParameter<std::vector<double> >( "mixed" )
+      && params.getParameter<std::vector<double> >( "mixed" ) == std::vector<double>{ 1., 2.5, -3. }, "mixed array promoted to double" );
+    check( params.hasParameter<std::vector<std::string> >( "strs" )
+      && params.getParameter<std::vector<std::string> >( "strs" ).size() == 2, "strings array" );
+    check( params.hasParameter<std::vector<ParametersList> >( "objs" )
+      && params.getParameter<std::vector<ParametersList> >( "objs" ).at( 1 ).getParameter<int>( "x" ) == 2, "objects array" );
+    check( params.hasParameter<ParametersList>( "sub" )
+      && params.getParameter<ParametersList>( "sub" ).getString( "name" ) == "sub", "nested object" );
+    check( params.type( "none" ) == ParametersList::invalid && params.type( "empty" ) == ParametersList::invalid,
+      "null values and empty arrays ignored" );
+  }
+  //--- integers beyond the int range
+  {
+    const ParametersList params = JsonParser::parse( "{ \"big\": 3000000000, \"small\": -3000000000, \"vec\": [1, 3000000000] }" );
+    check( params.hasParameter<double>( "big" ) && params.getParameter<double>( "big" ) == 3.e9, "large integer kept as double" );
+    check( params.hasParameter<double>( "small" ) && params.getParameter<double>( "small" ) == -3.e9, "large negative integer kept as double" );
+    check( params.hasParameter<std::vector<double> >( "vec" )
+      && params.getParameter<std::vector<double> >( "vec" ).at( 1 ) == 3.e9, "array with a large integer promoted to double" );
+  }
+  //--- escape sequences
+  {
+    const ParametersList params = JsonParser::parse(
+      "{ \"plain\": \"abc\", \"esc\": \"q\\\"b\\\\s\\/n\\nt\\t\", \"uni\": \"\\u0041\\u00e9\\u20ac\", \"k\\u0065y\": 1 }" );
+    check( params.getString( "plain" ) == "abc", "string without escape sequence" );
+    check( params.getString( "esc" ) == "q\"b\\s/n\nt\t", "escape sequences" );
+    check( params.getString( "uni" ) == "A\xc3\xa9\xe2\x82\xac", "unicode escape sequences" );
+    check( params.hasParameter<int>( "key" ), "escape sequence in a key" );
+  }
+  //--- comments and trailing commas
+  {
+    const ParametersList params = JsonParser::parse(
+      "# leading comment\n"
+      "{\n"
+      "  \"a\": 1, # trailing comment\n"
+      "  \"v\": [1, 2,],\n"
+      "  \"s\": \"# not a comment\",\n"
+      "}\n"
+      "# final comment" );
+    check( params.getParameter<int>( "a" ) == 1, "value followed by a comment" );
+    check( params.getParameter<std::vector<int> >( "v" ).size() == 2, "trailing comma in array" );
+    check( params.getString( "s" ) == "# not a comment", "comment character within a string" );
+  }
+  //--- errors and their positions
+  checkThrows( []() { JsonParser::parse( "{\n  \"a\": tru\n}" ); }, "invalid value (line 2, column 8)", "invalid keyword" );
+  checkThrows( []() { JsonParser::parse( "{ \"a\": 1 \"b\": 2 }" ); }, "expecting '}' (line 1, column 10)", "missing separator" );
+  checkThrows( []() { JsonParser::parse( "{ \"a\": \"abc }" ); }, "unterminated string", "unterminated string" );
+  checkThrows( []() { JsonParser::parse( "{ \"a\": \"\\q\" }" ); }, "invalid escape sequence", "invalid escape sequence" );
+  checkThrows( []() { JsonParser::parse( "{ \"a\": 1.2.3 }" ); }, "invalid number", "malformed number" );
+  checkThrows( []() { JsonParser::parse( "{ \"a\": [[1]] }" ); }, "nested arrays are not supported", "nested arrays" );
+  checkThrows( []() { JsonParser::parse( "{ \"a\": 1 } 2" ); }, "unexpected content after the top-level object", "trailing content" );
+  checkThrows( []() { JsonParser::parse( "{ \"a\": 1," ); }, "unexpected end of document", "truncated document" );
+  checkThrows( []() { JsonParser::parse( "{ \"a\": "+std::string( 80, '1' )+" }" ); }, "number too long (line 1, column 88)", "over-long number" );
+  //--- configuration cards which cannot be read
+  checkThrows( []() { JsonParser( "/nonexistent/card.json" ); }, "Failed to open", "missing card" );
+  checkThrows( []() { JsonParser( "/" ); }, "JsonParser:", "directory as a card" );
+
+  if ( num_failures > 0 ) {
+    IVUTILS_LOG( error ) << num_failures << " check(s) failed!";
+    return -1;
+  }
+  IVUTILS_LOG( info ) << "All checks passed.";
+  return 0;
+}
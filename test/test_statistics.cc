@@ -0,0 +1,124 @@
+#include "ivutils/Statistics.h"
+#include "ivutils/Logger.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <sstream>
+
+using namespace ivutils;
+
+namespace
+{
+  unsigned short num_failures = 0;
+
+  void
+  check( bool condition, const std::string& what )
+  {
+    if ( condition )
+      return;
+    IVUTILS_LOG( error ) << "Check failed: " << what << ".";
+    ++num_failures;
+  }
+
+  bool
+  close( double a, double b, double rel_tolerance )
+  {
+    return std::fabs( a-b ) <= rel_tolerance*std::max( std::fabs( a ), std::fabs( b ) );
+  }
+
+  /// Synthetic leakage current: baseline with a relative drift per value, gaussian noise, and a few spikes
+  std::vector<double>
+  currentSeries( size_t size, double drift, std::mt19937& gen )
+  {
+    std::normal_distribution<double> noise( 0., 1.e-11 );
+    std::vector<double> out( size );
+    for ( size_t i = 0; i < size; ++i )
+      out[i] = -1.e-9*( 1.+drift*i )+noise( gen )+( i % 997 == 5 ? 5.e-9 : 0. );
+    return out;
+  }
+
+  /// Fraction of the values strictly below a threshold
+  double
+  rank( const std::vector<double>& values, double threshold )
+  {
+    return (double)std::count_if( values.begin(), values.end(), [&threshold]( double v ) { return v < threshold; } )/values.size();
+  }
+}
+
+int main()
+{
+  std::mt19937 gen( 42 );
+
+  //--- batch update against the per-value update, for all remainders of the unrolled loops
+  for ( size_t size : { 1, 2, 3, 4, 5, 7, 8, 13, 1000, 10001 } ) {
+    const std::vector<double> values = currentSeries( size, 1.e-4, gen );
+    RunningStatistics single, batch, chunked;
+    for ( const auto& v : values )
+      single.add( v );
+    batch.add( values.data(), values.size() );
+    for ( size_t i = 0; i < values.size(); i += 7 )
+      chunked.add( values.data()+i, std::min<size_t>( 7, values.size()-i ) );
+    std::ostringstream os;
+    os << " (" << size << " values)";
+    for ( const auto* stat : { &batch, &chunked } ) {
+      check( stat->count() == single.count(), "count"+os.str() );
+      check( stat->min() == single.min() && stat->max() == single.max(), "extrema"+os.str() );
+      check( close( stat->mean(), single.mean(), 1.e-12 ), "mean"+os.str() );
+      check( close( stat->variance(), single.variance(), 1.e-9 ), "variance"+os.str() );
+    }
+  }
+  //--- empty batches and merges are neutral
+  {
+    RunningStatistics stat;
+    stat.add( nullptr, 0 );
+    stat.merge( RunningStatistics() );
+    check( stat.count() == 0 && stat.mean() == 0. && stat.variance() == 0., "empty batch" );
+    stat.add( 1. );
+    stat.add( 3. );
+    check( stat.mean() == 2. && stat.variance() == 1. && stat.sampleVariance() == 2., "two values" );
+  }
+
+  //--- P-square estimates against the exact quantiles
+  {
+    std::exponential_distribution<double> skewed( 1. );
+    std::uniform_real_distribution<double> flat( -1., 1. );
+    std::vector<std::vector<double> > series = { currentSeries( 20000, 0., gen ), {}, {} };
+    for ( size_t i = 0; i < 20000; ++i ) {
+      series[1].emplace_back( skewed( gen ) );
+      series[2].emplace_back( flat( gen ) );
+    }
+    for ( size_t s = 0; s < series.size(); ++s )
+      for ( double quantile : { 0.5, 0.1, 0.9 } ) {
+        P2Quantile estimator( quantile );
+        for ( const auto& v : series[s] )
+          estimator.add( v );
+        std::ostringstream os;
+        os << " (series " << s << ", quantile " << quantile << ", estimate at rank " << rank( series[s], estimator.value() ) << ")";
+        check( estimator.count() == series[s].size(), "P2 count"+os.str() );
+        check( std::fabs( rank( series[s], estimator.value() )-quantile ) < 0.01, "P2 accuracy"+os.str() );
+      }
+    //--- median absolute deviation of a gaussian noise
+    std::normal_distribution<double> noise( 5., 2. );
+    RunningMedian median;
+    for ( size_t i = 0; i < 20000; ++i )
+      median.add( noise( gen ) );
+    check( std::fabs( median.median()-5. ) < 0.1, "running median" );
+    check( std::fabs( median.mad()-0.6745*2. ) < 0.1, "median absolute deviation" );
+  }
+  //--- exact quantile of the first values
+  {
+    P2Quantile estimator( 0.5 );
+    check( estimator.value() == 0., "empty estimator" );
+    for ( double v : { 3., 1., 2. } )
+      estimator.add( v );
+    check( estimator.value() == 2., "median of three values" );
+  }
+
+  if ( num_failures > 0 ) {
+    IVUTILS_LOG( error ) << num_failures << " check(s) failed!";
+    return -1;
+  }
+  IVUTILS_LOG( info ) << "All checks passed.";
+  return 0;
+}